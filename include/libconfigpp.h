@@ -19,20 +19,65 @@
 #define LIBCONFIGPP_H
 
 #include <stdexcept>
+#include <cstdlib>
+#include <new>
+#include <limits>
 #include <map>
 #include <vector>
 #include <algorithm>
+#include <iterator>
+#include <cstddef>
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <locale>
 #include <fstream>
-#include <boost/scoped_ptr.hpp>
+#include <boost/move/unique_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/type_with_alignment.hpp>
+#include <boost/type_traits/is_pointer.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/remove_cv.hpp>
+#include <boost/type_traits/remove_pointer.hpp>
 #include <boost/static_assert.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/regex.hpp>
-#include <boost/any.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/utility/base_from_member.hpp>
+#include <boost/config.hpp>
+
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_HDR_MUTEX) && \
+    !defined(BOOST_NO_CXX11_THREAD_LOCAL)
+#define LIBCONFIGPP_HAS_THREADS
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#endif
+
+#ifndef BOOST_NO_CXX11_HDR_FUTURE
+#define LIBCONFIGPP_HAS_FUTURES
+#include <future>
+#endif
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#define LIBCONFIGPP_HAS_MEMORY_RESOURCE
+#include <memory_resource>
+#endif
+#if __has_include(<charconv>)
+#include <charconv>
+#ifdef __cpp_lib_to_chars
+#define LIBCONFIGPP_HAS_FROM_CHARS
+#endif
+#endif
+#endif
 
 namespace libconfig {
 
@@ -155,15 +200,383 @@ private:
     size_t m_offset;
 };
 
+/*!
+ * \brief upper bounds enforced while reading a configuration
+ *
+ * A value of 0 disables the corresponding check. Violations are reported
+ * as ParseException as soon as they are detected.
+ */
+struct ParseLimits
+{
+    ParseLimits()
+        : maxBytes(0),
+          maxNodes(0),
+          maxDepth(0),
+          maxIncludes(0),
+          maxStringLength(0)
+    {}
+
+    size_t maxBytes;        //!< total bytes read, including included files
+    size_t maxNodes;        //!< number of settings
+    size_t maxDepth;        //!< nesting depth of groups, lists and arrays
+    size_t maxIncludes;     //!< number of included files
+    size_t maxStringLength; //!< length of a string or any other token
+};
+
+/*!
+ * \brief interned setting names shared by the settings of a config
+ *
+ * Every distinct name is stored once and identified by a small integer
+ * atom. The empty name is always atom 0. Strings live in blocks of doubling
+ * size that are never moved or freed before the table, so name() reads
+ * without locking. intern() serializes on a mutex when threads are
+ * available, since parallel parsing interns from several threads. find()
+ * runs on every lookup of a path and takes no lock: the hash index only
+ * grows, and an index that was replaced by a bigger one is kept until the
+ * table is destroyed.
+ *
+ * The paths of the files the settings were read from are interned here
+ * as well, so a setting records its source file as one atom.
+ */
+template<typename charT>
+class basic_atom_table : boost::noncopyable
+{
+public:
+    typedef charT char_type;
+    typedef typename std::basic_string<charT> string_type;
+    typedef unsigned int atom_type;
+
+    static const atom_type npos = static_cast<atom_type>(-1);
+
+    /*!
+     * \brief guards the links between the lists of the trees using a table
+     * and the pending copies of those lists
+     *
+     * Copies keep the guard of their source alive, so it may outlive the
+     * table. pending is read without locking to skip the mutex while no
+     * copies are linked.
+     */
+    struct copy_guard : boost::noncopyable
+    {
+        copy_guard()
+            : pending(0)
+        {}
+
+#ifdef LIBCONFIGPP_HAS_THREADS
+        std::recursive_mutex mutex;     //!< recursive because filling a copy links the next level
+        std::atomic<size_t> pending;    //!< copies linked to lists of the trees
+#else
+        size_t pending;
+#endif
+    };
+
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+    /*!
+     * \brief creates a table whose trees allocate their settings from
+     * resource, or from the global heap if resource is 0
+     */
+    explicit basic_atom_table(std::pmr::memory_resource* resource = 0)
+        : m_size(0),
+          m_generation(0),
+          m_copies(new copy_guard()),
+          m_resource(resource),
+          m_lists(this)
+#else
+    basic_atom_table()
+        : m_size(0),
+          m_generation(0),
+          m_copies(new copy_guard())
+#endif
+    {
+        std::fill(m_blocks, m_blocks + max_blocks, static_cast<string_type*>(0));
+        m_indexes.push_back(new _index(2 * first_block));
+        m_index = m_indexes.back();
+        intern(string_type());
+    }
+
+    ~basic_atom_table()
+    {
+        for (size_t i = 0; i < max_blocks; i++) {
+            delete[] m_blocks[i];
+        }
+        for (size_t i = 0; i < m_indexes.size(); i++) {
+            delete m_indexes[i];
+        }
+    }
+
+    /*!
+     * \brief returns the atom of name, adding name if it is new
+     */
+    atom_type intern(const string_type& name)
+    {
+#ifdef LIBCONFIGPP_HAS_THREADS
+        std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+        size_t hash = _hash(name);
+        _index* index = m_index;
+        atom_type atom = _find(*index, name, hash);
+        if (atom != npos) {
+            return atom;
+        }
+
+        size_t offset;
+        size_t block = _block(m_size, &offset);
+        if (block >= max_blocks) {
+            throw ConfigException("too many distinct setting names");
+        }
+        if (!m_blocks[block]) {
+            m_blocks[block] = new string_type[first_block << block];
+        }
+        m_blocks[block][offset] = name;
+        if ((m_size + 1) * 2 > index->size()) {
+            index = _grow(index);
+        }
+        // the slot is written last, a reader that finds it sees the name
+        _insert(*index, m_size, hash);
+        return m_size++;
+    }
+
+    /*!
+     * \brief returns the atom of name or npos if name was never interned
+     */
+    atom_type find(const string_type& name) const
+    {
+        const _index* index = m_index;
+        return _find(*index, name, _hash(name));
+    }
+
+    const string_type& name(atom_type atom) const
+    {
+        size_t offset;
+        size_t block = _block(atom, &offset);
+        BOOST_ASSERT(block < max_blocks && m_blocks[block]);
+        return m_blocks[block][offset];
+    }
+
+    /*!
+     * \brief returns a counter that changes whenever settings of the trees
+     * using this table are destroyed
+     */
+    unsigned long generation() const
+    {
+        return m_generation;
+    }
+
+    void invalidate()
+    {
+        m_generation++;
+    }
+
+    const boost::shared_ptr<copy_guard>& copies() const
+    {
+        return m_copies;
+    }
+
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+    std::pmr::memory_resource* resource() const
+    {
+        return m_resource;
+    }
+
+    /*!
+     * \brief allocates from the resource, serialized because parallel
+     * parses create settings of one tree on several threads
+     */
+    void* allocate(size_t size, size_t alignment)
+    {
+#ifdef LIBCONFIGPP_HAS_THREADS
+        std::lock_guard<std::mutex> lock(m_resource_mutex);
+#endif
+        return m_resource->allocate(size, alignment);
+    }
+
+    void deallocate(void* p, size_t size, size_t alignment)
+    {
+#ifdef LIBCONFIGPP_HAS_THREADS
+        std::lock_guard<std::mutex> lock(m_resource_mutex);
+#endif
+        m_resource->deallocate(p, size, alignment);
+    }
+
+    /*!
+     * \brief returns the resource the children lists of the trees allocate
+     * from, which forwards to allocate(), or the global heap if there is
+     * no resource
+     */
+    std::pmr::memory_resource* lists()
+    {
+        return m_resource ? &m_lists : std::pmr::new_delete_resource();
+    }
+#endif
+
+private:
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+    struct _list_resource : std::pmr::memory_resource
+    {
+        explicit _list_resource(basic_atom_table* table)
+            : table(table)
+        {}
+
+        void* do_allocate(size_t size, size_t alignment)
+        {
+            return table->allocate(size, alignment);
+        }
+
+        void do_deallocate(void* p, size_t size, size_t alignment)
+        {
+            table->deallocate(p, size, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept
+        {
+            return this == &other;
+        }
+
+        basic_atom_table* table;
+    };
+#endif
+
+    enum {
+        first_block = 64,
+        max_blocks = 26
+    };
+
+#ifdef LIBCONFIGPP_HAS_THREADS
+    typedef std::atomic<atom_type> slot_type;
+#else
+    typedef atom_type slot_type;
+#endif
+
+    /*!
+     * \brief open addressing hash index of atoms + 1, 0 marks an empty slot
+     */
+    struct _index : boost::noncopyable
+    {
+        explicit _index(size_t size)
+            : mask(size - 1),
+              slots(new slot_type[size])
+        {
+            for (size_t i = 0; i < size; i++) {
+                slots[i] = 0;
+            }
+        }
+
+        ~_index()
+        {
+            delete[] slots;
+        }
+
+        size_t size() const
+        {
+            return mask + 1;
+        }
+
+        size_t mask;
+        slot_type* slots;
+    };
+
+    static size_t _hash(const string_type& name)
+    {
+        return boost::hash_range(name.begin(), name.end());
+    }
+
+    atom_type _find(const _index& index, const string_type& name, size_t hash) const
+    {
+        for (size_t i = hash & index.mask; ; i = (i + 1) & index.mask) {
+            atom_type slot = index.slots[i];
+            if (!slot) {
+                return npos;
+            } else if (this->name(slot - 1) == name) {
+                return slot - 1;
+            }
+        }
+    }
+
+    static void _insert(_index& index, atom_type atom, size_t hash)
+    {
+        size_t i = hash & index.mask;
+        while (index.slots[i]) {
+            i = (i + 1) & index.mask;
+        }
+        index.slots[i] = atom + 1;
+    }
+
+    /*!
+     * \brief replaces the index by one of twice the size, the old one stays
+     * readable for lookups still probing it
+     */
+    _index* _grow(const _index* index)
+    {
+        m_indexes.reserve(m_indexes.size() + 1);
+        _index* bigger = new _index(2 * index->size());
+        for (atom_type atom = 0; atom < m_size; atom++) {
+            _insert(*bigger, atom, _hash(name(atom)));
+        }
+        m_indexes.push_back(bigger);
+        m_index = bigger;
+        return bigger;
+    }
+
+    /*!
+     * \brief block k holds first_block << k atoms, starting at first_block * (2^k - 1)
+     */
+    static size_t _block(size_t atom, size_t* offset)
+    {
+        size_t n = atom / first_block + 1;
+        size_t block = 0;
+        while (n >>= 1) {
+            block++;
+        }
+        *offset = atom - first_block * ((static_cast<size_t>(1) << block) - 1);
+        return block;
+    }
+
+    string_type* m_blocks[max_blocks];
+    atom_type m_size;
+    unsigned long m_generation;
+#ifdef LIBCONFIGPP_HAS_THREADS
+    std::atomic<_index*> m_index;   //!< newest of m_indexes, read without locking
+#else
+    _index* m_index;
+#endif
+    std::vector<_index*> m_indexes; //!< every index so far, freed with the table
+    boost::shared_ptr<copy_guard> m_copies;
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+    std::pmr::memory_resource* m_resource;
+    _list_resource m_lists;
+#endif
+#ifdef LIBCONFIGPP_HAS_THREADS
+    std::mutex m_mutex;             //!< serializes intern()
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+    std::mutex m_resource_mutex;    //!< serializes allocations from the resource
+#endif
+#endif
+};
+
+template<typename charT>
+const typename basic_atom_table<charT>::atom_type basic_atom_table<charT>::npos;
+
 template<typename charT>
 class basic_config;
 
+template<typename charT>
+class basic_setting_table;
+
+template<typename charT>
+class basic_setting_ref;
+
 template<typename charT>
 class basic_setting
 {
+    friend class basic_config<charT>;
+    friend class basic_setting_table<charT>;
+    friend class basic_setting_ref<charT>;
+
 public:
     typedef charT char_type;
     typedef typename std::basic_string<charT> string_type;
+    typedef basic_atom_table<charT> atom_table;
+    typedef typename atom_table::atom_type atom_type;
 
     enum Type {
         TypeInt,
@@ -183,43 +596,40 @@ public:
 
     basic_setting& operator=(bool value)
     {
-        m_value->assignValue(value);
+        _assign(value);
         return *this;
     }
 
     basic_setting& operator=(int value)
     {
-        m_value->assignValue(value);
+        _assign(static_cast<long>(value));
         return *this;
     }
 
     basic_setting& operator=(long value)
     {
-        m_value->assignValue(value);
+        _assign(value);
         return *this;
     }
 
     basic_setting& operator=(float value)
     {
-        m_value->assignValue(value);
+        _assign(value);
         return *this;
     }
 
     basic_setting& operator=(const string_type& value)
     {
-        m_value->assignValue(value);
+        _assign(value);
         return *this;
     }
 
     bool operator==(const basic_setting& other) const
     {
-        if (m_name == other.m_name && m_type == other.m_type) {
-            if (m_value && other.m_value) {
-                return *m_value == *other.m_value;
-            } else if (!m_value && !other.m_value) {
-                return true;
-            }
-            return true;
+        bool same_name = m_atoms == other.m_atoms ? m_name == other.m_name
+                                                  : getName() == other.getName();
+        if (same_name && m_type == other.m_type) {
+            return _equal_value(other);
         }
         return false;
     }
@@ -227,59 +637,74 @@ public:
     operator bool () const
     {
         bool result;
-        m_value->lookupValue(result);
+        _lookup(result);
         return result;
     }
 
     operator int () const
     {
         int result;
-        m_value->lookupValue(result);
+        _lookup(result);
         return result;
     }
 
     operator unsigned () const
     {
         unsigned result;
-        m_value->lookupValue(result);
+        _lookup(result);
         return result;
     }
 
     operator long () const
     {
         long result;
-        m_value->lookupValue(result);
+        _lookup(result);
         return result;
     }
 
     operator unsigned long () const
     {
         unsigned long result;
-        m_value->lookupValue(result);
+        _lookup(result);
         return result;
     }
 
     operator float () const
     {
         float result;
-        m_value->lookupValue(result);
+        _lookup(result);
         return result;
     }
 
     operator double () const
     {
         double result;
-        m_value->lookupValue(result);
+        _lookup(result);
         return result;
     }
 
     operator string_type () const
     {
         string_type result;
-        m_value->lookupValue(result);
+        _lookup(result);
         return result;
     }
 
+    /*!
+     * \brief returns the stored string without copying it
+     *
+     * The reference stays valid until the setting is assigned or destroyed.
+     */
+    const string_type& getString() const
+    {
+        return _string();
+    }
+
+    const char_type* c_str() const
+    {
+        return _string().c_str();
+    }
+
     virtual ~basic_setting() {}
 
     basic_setting& operator[](const char * index)
@@ -305,13 +730,13 @@ public:
     basic_setting& operator[](int index)
     {
         _check_index(index);
-        return m_value->at(index);
+        return _child(index);
     }
 
     const basic_setting& operator[](int index) const
     {
         _check_index(index);
-        return m_value->at(index);
+        return _child(index);
     }
 
     bool lookupValue(const string_type& path, bool& value) const
@@ -387,189 +812,367 @@ public:
     bool lookupValue(const string_type& path, string_type& value) const
     {
         try {
-            value = static_cast<string_type>(_at(path));
+            value = _at(path)._string();
             return true;
         } catch (std::exception&) {
             return false;
         }
     }
 
-    basic_setting& add(Type type)
-    {
-        return m_value->add(basic_setting(string_type(), type));
-    }
-
-    basic_setting& add(const string_type &name, Type type)
-    {
-        return m_value->add(basic_setting(name, type));
-    }
-
-    void remove(const string_type& path)
+    /*!
+     * \brief points value at the stored string instead of copying it
+     */
+    bool lookupValue(const string_type& path, const char_type*& value) const
     {
-        _check_path(path);
-        _at(_parent(path)).m_value->remove(_leaf(path));
+        try {
+            value = _at(path)._string().c_str();
+            return true;
+        } catch (std::exception&) {
+            return false;
+        }
     }
 
-    void remove(size_t position)
+    basic_setting& add(Type type)
     {
-        m_value->remove(position);
+        return _emplace(string_type(), type);
     }
 
-    string_type getName() const
+    basic_setting& add(const string_type &name, Type type)
     {
-        return m_name;
+        return _emplace(name, type);
     }
 
-    string_type getPath() const
+    /*!
+     * \brief reserves room for count children of a group, list or array
+     */
+    void reserve(size_t count)
     {
-        string_type path;
-        if(m_parent) {
-            path += m_parent->getPath();
+        if (!m_children) {
+            return;
         }
-
-        if (path.size() > 0) {
-            path += '.';
+        _materialize();
+        if (m_type == TypeArray) {
+            m_children->packed.reserve(count);
+        } else {
+            m_children->items.reserve(count);
         }
+    }
 
-        path += m_name;
-        return path;
+    /*!
+     * \brief creates a scalar child holding value in place
+     *
+     * The type follows from value: bool, int, long, float or double and
+     * strings make TypeBoolean, TypeInt, TypeInt64, TypeFloat and
+     * TypeString.
+     */
+    basic_setting& emplace(const string_type& name, bool value)
+    {
+        return _emplace_value(name, value);
     }
 
-    const basic_setting& getParent() const
+    basic_setting& emplace(const string_type& name, int value)
     {
-        if(!m_parent)
-            throw _not_found_ex("parent");
-        return *m_parent;
+        return _emplace_value(name, value);
     }
 
-    basic_setting& getParent()
+    basic_setting& emplace(const string_type& name, long value)
     {
-        if(!m_parent)
-            throw _not_found_ex("parent");
-        return *m_parent;
+        return _emplace_value(name, value);
     }
 
-    int getIndex() const
+    basic_setting& emplace(const string_type& name, float value)
     {
-        if(m_parent) {
-            return m_parent->indexOf(*this);
-        }
-        return -1;
+        return _emplace_value(name, value);
     }
 
-    Type getType() const
+    basic_setting& emplace(const string_type& name, double value)
     {
-        return m_type;
+        return _emplace_value(name, static_cast<float>(value));
     }
 
-    Format getFormat() const
+    basic_setting& emplace(const string_type& name, const string_type& value)
     {
-        return m_value->format();
+        return _emplace_value(name, value);
     }
 
-    void setFormat(const Format& f)
+    basic_setting& emplace(const string_type& name, const char_type* value)
     {
-        m_value->set_format(f);
+        return _emplace_value(name, string_type(value));
     }
 
-    bool exists(const string_type& path) const
+    /*!
+     * \brief appends value to a list or array, arrays store it packed
+     * without creating a setting
+     */
+    void append(bool value)
     {
-        _check_path(path);
-        return _exists(path);
+        _append_value(value);
     }
 
-    size_t getLength() const
+    void append(int value)
     {
-        return m_value->size();
+        _append_value(value);
     }
 
-    bool isGroup() const
+    void append(long value)
     {
-        return m_type == TypeGroup;
+        _append_value(value);
     }
 
-    bool isArray() const
+    void append(float value)
     {
-        return m_type == TypeArray;
+        _append_value(value);
     }
 
-    bool isList() const
+    void append(double value)
     {
-        return m_type == TypeList;
+        _append_value(static_cast<float>(value));
     }
 
-    bool isAggredate() const
+    void append(const string_type& value)
     {
-        return isGroup() || isArray() || isList();
+        _append_value(value);
     }
 
-    bool isScalar() const
+    void append(const char_type* value)
     {
-        return isNumber() ||
-                m_type == TypeBoolean ||
-                m_type == TypeString;
+        _append_value(string_type(value));
     }
 
-    bool isNumber() const
+    /*!
+     * \brief converts all elements of this array into values at once
+     *
+     * The element type is checked once for the whole array, the conversions
+     * follow the rules of the conversion operators.
+     */
+    template<typename T>
+    void getArray(std::vector<T>& values) const
     {
-        switch (m_type) {
+        if (m_type != TypeArray) {
+            throw _type_ex("setting is not an array");
+        }
+        _materialize();
+        const _packed_array& packed = m_children->packed;
+        if (packed.size() == 0) {
+            values.clear();
+            return;
+        }
+        switch(packed.element) {
+        case TypeBoolean:
+            _convert_array(packed.booleans, values);
+            break;
         case TypeInt:
+            _convert_array(packed.integers, values);
+            break;
         case TypeInt64:
+            _convert_array(packed.integers64, values);
+            break;
         case TypeFloat:
-            return true;
+            _convert_array(packed.floats, values);
+            break;
         default:
-            return false;
+            _convert_array(packed.strings, values);
         }
     }
 
-    bool isRoot() const
+    template<typename T>
+    void getArray(const string_type& path, std::vector<T>& values) const
     {
-        return !m_parent;
+        _at(path).getArray(values);
     }
 
-    const char* getSourceFile() const
+    /*!
+     * \brief replaces the elements of the array at path with values
+     *
+     * The array is added to its parent group if it does not exist yet, a
+     * parent that is not a group throws SettingTypeException. Values of type bool, int, long, float, double, strings and C strings
+     * are copied into the array in one pass, settings taken from the old
+     * elements become invalid.
+     */
+    template<typename T>
+    void setArray(const string_type& path, const T* values, size_t count)
     {
-        return m_file.c_str();
+        _array_at(path)._set_array(values, values + count);
     }
 
-    int getSourceLine() const
+    template<typename T>
+    void setArray(const string_type& path, const std::vector<T>& values)
     {
-        return m_line;
+        _array_at(path)._set_array(values.begin(), values.end());
     }
 
-    template<typename T>
-    friend std::ostream& operator<<(std::ostream &o, const basic_setting<T>& rhs);
-protected:
+    void remove(const string_type& path)
+    {
+        _check_path(path);
+        _at(_parent(path))._remove(_leaf(path));
+    }
 
-    basic_setting(const string_type &name, const Type& type = TypeGroup)
-        : m_name(name),
-          m_type(type),
-          m_parent(0)
+    void remove(size_t position)
     {
-        switch (type) {
-        case TypeBoolean:
-            m_value.reset(new _basic_setting_scalar<bool>());
-            break;
+        _remove(position);
+    }
+
+    string_type getName() const
+    {
+        return m_atoms->name(m_name);
+    }
+
+    string_type getPath() const
+    {
+        string_type path;
+        appendPath(path);
+        return path;
+    }
+
+    /*!
+     * \brief appends the path of this setting to path
+     *
+     * The length is computed first and the names are copied in place, so
+     * nothing is allocated if path already has the capacity.
+     */
+    void appendPath(string_type& path) const
+    {
+        size_t length = _path_length();
+        size_t base = path.size();
+        path.resize(base + length);
+        if (length) {
+            _write_path(&path[base] + length, length);
+        }
+    }
+
+    const basic_setting& getParent() const
+    {
+        if(!m_parent)
+            throw _not_found_ex("parent");
+        return *m_parent;
+    }
+
+    basic_setting& getParent()
+    {
+        if(!m_parent)
+            throw _not_found_ex("parent");
+        return *m_parent;
+    }
+
+    int getIndex() const
+    {
+        if(m_parent) {
+            return m_position;
+        }
+        return -1;
+    }
+
+    Type getType() const
+    {
+        return m_type;
+    }
+
+    Format getFormat() const
+    {
+        return m_format;
+    }
+
+    void setFormat(const Format& f)
+    {
+        if (isScalar()) {
+            _unshare();
+            m_format = f;
+            _write_back();
+        }
+    }
+
+    bool exists(const string_type& path) const
+    {
+        _check_path(path);
+        return _exists(path);
+    }
+
+    size_t getLength() const
+    {
+        return _size();
+    }
+
+    bool isGroup() const
+    {
+        return m_type == TypeGroup;
+    }
+
+    bool isArray() const
+    {
+        return m_type == TypeArray;
+    }
+
+    bool isList() const
+    {
+        return m_type == TypeList;
+    }
+
+    bool isAggredate() const
+    {
+        return isGroup() || isArray() || isList();
+    }
+
+    bool isScalar() const
+    {
+        return isNumber() ||
+                m_type == TypeBoolean ||
+                m_type == TypeString;
+    }
+
+    bool isNumber() const
+    {
+        switch (m_type) {
+        case TypeInt:
+        case TypeInt64:
+        case TypeFloat:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool isRoot() const
+    {
+        return !m_parent;
+    }
+
+    const char* getSourceFile() const
+    {
+        return m_atoms->name(m_file).c_str();
+    }
+
+    int getSourceLine() const
+    {
+        return m_line;
+    }
+
+
+    template<typename T>
+    friend std::ostream& operator<<(std::ostream &o, const basic_setting<T>& rhs);
+protected:
+
+    basic_setting(atom_table* atoms, const string_type &name, const Type& type = TypeGroup)
+        : m_atoms(atoms),
+          m_name(atoms->intern(name)),
+          m_type(type),
+          m_format(FormatDefault),
+          m_file(0),
+          m_line(0),
+          m_parent(0),
+          m_position(0),
+          m_scalar(type)
+    {
+        switch (type) {
+        case TypeBoolean:
         case TypeInt:
-            m_value.reset(new _basic_setting_scalar<int>());
-            break;
         case TypeInt64:
-            m_value.reset(new _basic_setting_scalar<long>());
-            break;
         case TypeFloat:
-            m_value.reset(new _basic_setting_scalar<float>());
-            break;
         case TypeString:
-            m_value.reset(new _basic_setting_scalar<string_type>());
             break;
         case TypeArray:
-            m_value.reset(new _basic_setting_array(this));
-            break;
         case TypeList:
-            m_value.reset(new _basic_setting_list(this));
-            break;
         case TypeGroup:
-            m_value.reset(new _basic_setting_container(this));
+            m_children.reset(_new_children(atoms, type == TypeGroup));
             break;
         default:
             throw _type_ex("Unknown type");
@@ -577,41 +1180,207 @@ protected:
     }
 
     basic_setting(const basic_setting& other)
-        : m_name(other.m_name),
+        : m_atoms(other.m_atoms),
+          m_name(other.m_name),
+          m_type(other.m_type),
+          m_format(other.m_format),
+          m_file(other.m_file),
+          m_line(other.m_line),
+          m_parent(0),
+          m_position(0),
+          m_scalar(other.m_scalar)
+    {
+        _copy_children(other);
+    }
+
+    /*!
+     * \brief copies other, interning its names in atoms
+     */
+    basic_setting(const basic_setting& other, atom_table* atoms)
+        : m_atoms(atoms),
+          m_name(atoms == other.m_atoms ? other.m_name : atoms->intern(other.getName())),
           m_type(other.m_type),
+          m_format(other.m_format),
+          m_file(atoms == other.m_atoms ? other.m_file : atoms->intern(other.getSourceFile())),
+          m_line(other.m_line),
           m_parent(0),
-          m_value(other.m_value->clone(this))
+          m_position(0),
+          m_scalar(other.m_scalar)
     {
+        _copy_children(other);
     }
 
-    basic_setting(const string_type &name, const std::vector<basic_setting>& values, Type type)
-        : m_name(name),
+    basic_setting(atom_table* atoms, const string_type &name,
+                  const std::vector<basic_setting>& values, Type type)
+        : m_atoms(atoms),
+          m_name(atoms->intern(name)),
           m_type(type),
+          m_format(FormatDefault),
+          m_file(0),
+          m_line(0),
           m_parent(0),
-          m_value(new _basic_setting_list(this, values))
+          m_position(0),
+          m_scalar(type),
+          m_children(_new_children(atoms, false))
     {
         BOOST_ASSERT(type == TypeList || type == TypeArray);
+        for(size_t i=0; i<values.size(); i++) {
+            _append(values[i]);
+        }
     }
 
     basic_setting& operator =(const basic_setting& other)
     {
         if (this != &other) {
-            m_name = other.m_name;
-            m_type = other.m_type;
-            m_value.reset(other.m_value->clone(this));
+            basic_setting copy(other);
+            swap(copy);
+            copy.m_atoms->invalidate();
+        }
+        return *this;
+    }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    /*!
+     * \brief takes name, value and children of other without cloning
+     *
+     * other is left an empty setting of the same type.
+     */
+    basic_setting(basic_setting&& other)
+        : m_atoms(other.m_atoms),
+          m_name(0),
+          m_type(other.m_type),
+          m_format(FormatDefault),
+          m_file(0),
+          m_line(0),
+          m_parent(0),
+          m_position(0),
+          m_scalar(other.m_type)
+    {
+        if (other.m_children) {
+            m_children.reset(_new_children(m_atoms, m_type == TypeGroup));
+        }
+        swap(other);
+        m_atoms->invalidate();
+    }
+
+    basic_setting& operator =(basic_setting&& other)
+    {
+        if (this != &other) {
+            basic_setting moved(static_cast<basic_setting&&>(other));
+            swap(moved);
+            moved.m_atoms->invalidate();
         }
         return *this;
     }
+#endif
 
     basic_setting& add(const basic_setting& setting)
     {
-        return m_value->add(setting);
+        return _add(setting);
     }
 
-    string_type m_file;
-    size_t m_line;
+    /*!
+     * \brief adds a copy of setting like add, but returns nothing, so that
+     * array elements are only stored packed
+     */
+    void append(const basic_setting& setting)
+    {
+        _append(setting);
+    }
+
+    typedef boost::function<void (basic_setting&)> loader_type;
+
+    /*!
+     * \brief defers creation of the children of a group, list or array
+     * \param loader called with this setting on first access of the children
+     */
+    void defer(const loader_type& loader)
+    {
+        if (!m_children) {
+            throw ConfigException("operation not supported");
+        }
+        _unshare();
+        m_children->clear();
+        m_children->set_loader(loader);
+    }
+
+    /*!
+     * \brief rebuilds the children in depth-first order with exact capacities
+     *
+     * Settings added and removed over time end up scattered over the heap.
+     * compact() allocates the subtree again, each setting right before its
+     * children, and frees the old one. Paths and values stay the same, but
+     * references to the settings below this one are invalidated. Deferred
+     * and not yet copied parts of the subtree are kept as they are.
+     */
+    void compact()
+    {
+        if (!m_children || m_children->source || m_children->loader) {
+            return;
+        }
+        children_ptr old(_new_children(m_atoms, m_type == TypeGroup));
+        old.swap(m_children);
+        m_children->owner = this;
+        try {
+            _compact(*old);
+        } catch (...) {
+            old.swap(m_children);
+            throw;
+        }
+        m_atoms->invalidate();
+    }
+
+    /*!
+     * \brief exchanges name, type and value with other without cloning
+     * \param other setting to swap with
+     */
+    void swap(basic_setting& other)
+    {
+        // the children lists move along with their pending copies
+        if (m_parent) {
+            m_parent->_unshare();
+        }
+        if (other.m_parent) {
+            other.m_parent->_unshare();
+        }
+        std::swap(m_atoms, other.m_atoms);
+        std::swap(m_name, other.m_name);
+        std::swap(m_type, other.m_type);
+        std::swap(m_format, other.m_format);
+        std::swap(m_file, other.m_file);
+        std::swap(m_line, other.m_line);
+        m_scalar.swap(other.m_scalar);
+        m_children.swap(other.m_children);
+        _rebind();
+        other._rebind();
+        _write_back();
+        other._write_back();
+    }
 
 private:
+    /*!
+     * \brief containers of the children lists, which allocate from the
+     * memory resource of the tree where there is one
+     */
+    template<typename T>
+    struct _list
+    {
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+        typedef std::pmr::vector<T> type;
+#else
+        typedef std::vector<T> type;
+#endif
+    };
+
+    typedef boost::shared_ptr<basic_setting> value_ptr;
+    typedef typename _list<value_ptr>::type value_array;
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+    typedef std::pmr::unordered_map<size_t, value_ptr> element_map;
+#else
+    typedef boost::unordered_map<size_t, value_ptr> element_map;
+#endif
+    typedef typename atom_table::copy_guard copy_guard;
+
     string_type _local(const string_type& path) const
     {
         if (_long_path(path)) {
@@ -654,20 +1423,20 @@ private:
         size_t index = 0;
         if(!_long_path(path)) {
             if(_convert_index(path, &index)) {
-                return m_value->exists(index);
+                return _find(index) != 0;
             } else {
-                return m_value->exists(path);
+                return _find(path) != 0;
             }
         } else {
             string_type local = _local(path);
             string_type remote = _remote(path);
             if(_convert_index(path, &index)) {
-                if(m_value->exists(index)) {
-                    return m_value->at(index)._exists(remote);
+                if(_find(index)) {
+                    return _child(index)._exists(remote);
                 }
             } else {
-                if (m_value->exists(local)) {
-                    return m_value->at(local)._exists(remote);
+                if (_find(local)) {
+                    return _child(local)._exists(remote);
                 }
             }
         }
@@ -684,17 +1453,17 @@ private:
             size_t index = 0;
             if(!_long_path(path)) {
                 if(_convert_index(path, &index)) {
-                    return m_value->at(index);
+                    return _child(index);
                 } else {
-                    return m_value->at(path);
+                    return _child(path);
                 }
             } else {
                 string_type local = _local(path);
                 string_type remote = _remote(path);
                 if(_convert_index(local, &index)) {
-                    return m_value->at(index)._at(remote);
+                    return _child(index)._at(remote);
                 } else {
-                    return m_value->at(local)._at(remote);
+                    return _child(local)._at(remote);
                 }
             }
         } catch (SettingNotFoundException &ex) {
@@ -712,17 +1481,17 @@ private:
             size_t index = 0;
             if(!_long_path(path)) {
                 if(_convert_index(path, &index)) {
-                    return m_value->at(index);
+                    return _child(index);
                 } else {
-                    return m_value->at(path);
+                    return _child(path);
                 }
             } else {
                 string_type local = _local(path);
                 string_type remote = _remote(path);
                 if(_convert_index(local, &index)) {
-                    return m_value->at(index)._at(remote);
+                    return static_cast<const basic_setting&>(_child(index))._at(remote);
                 } else {
-                    return m_value->at(local)._at(remote);
+                    return static_cast<const basic_setting&>(_child(local))._at(remote);
                 }
             }
         } catch (SettingNotFoundException &ex) {
@@ -744,1038 +1513,2908 @@ private:
         return false;
     }
 
-    void print(std::ostream& o, size_t level) const
+    size_t _path_length() const
     {
-        if (!m_name.empty()) {
-            o << m_name << " = ";
-        }
-        m_value->print(o, level);
-    }
-
-    template <typename T>
-    static typename basic_setting<charT>::Type _deduce_scalar_type(const T&) {
-        BOOST_STATIC_ASSERT(sizeof(T) == 0);
+        size_t parent = m_parent ? m_parent->_path_length() : 0;
+        return parent + (parent ? 1 : 0) + m_atoms->name(m_name).size();
     }
 
-    static Type _deduce_scalar_type(const bool&) {
-        return TypeBoolean;
-    }
-
-    static Type _deduce_scalar_type(const int&) {
-        return TypeInt;
-    }
-
-    static Type _deduce_scalar_type(const long&) {
-        return TypeInt64;
-    }
-
-    static Type _deduce_scalar_type(const float&) {
-        return TypeFloat;
-    }
-
-    static Type _deduce_scalar_type(const string_type&) {
-        return TypeString;
+    /*!
+     * \brief writes the path of length characters that ends just before end
+     */
+    void _write_path(char_type* end, size_t length) const
+    {
+        const string_type& name = m_atoms->name(m_name);
+        end = std::copy_backward(name.begin(), name.end(), end);
+        if (length > name.size()) {
+            *--end = '.';
+            m_parent->_write_path(end, length - name.size() - 1);
+        }
     }
 
-    int indexOf(const basic_setting& child) const
+    void print(std::ostream& o, size_t level) const
     {
-        if (m_value) {
-            return m_value->indexOf(child);
+        if (m_name) {
+            o << getName() << " = ";
         }
-        return -1;
+        _print_value(o, level);
     }
 
-    class _basic_setting
+    /*!
+     * \brief tagged union holding the value of a scalar setting
+     *
+     * Numbers and strings share inline storage, the tag is the scalar type
+     * which never changes after construction. Aggregates keep no value.
+     * A number may instead hold the raw text it was read from, set by
+     * setText(); the text is converted on first access and the value is
+     * kept in its place.
+     */
+    class _scalar_value
     {
     public:
-        virtual _basic_setting* clone(basic_setting* new_container) = 0;
-
-        virtual bool operator==(const _basic_setting& other) const = 0;
-
-        virtual void print(std::ostream&, size_t level) const = 0;
-
-        virtual void lookupValue(bool&) {
-            throw _type_ex("converion not implemented");
-        }
-
-        virtual void assignValue(bool) {
-            throw _type_ex("converion not supported");
-
+        explicit _scalar_value(Type type)
+            : m_type(type),
+              m_raw(false)
+        {
+            switch(m_type) {
+            case TypeBoolean:
+                m_bool = false;
+                break;
+            case TypeInt:
+                m_int = 0;
+                break;
+            case TypeFloat:
+                m_float = 0;
+                break;
+            case TypeString:
+                new (m_string) string_type();
+                break;
+            default:
+                m_long = 0;
+            }
         }
 
-        virtual void lookupValue(int&) {
-            throw _type_ex("converion not implemented");
+        _scalar_value(const _scalar_value& other)
+            : m_type(other.m_type),
+              m_raw(false)
+        {
+            _copy(other);
         }
 
-        virtual void assignValue(int) {
-            throw _type_ex("converion not supported");
-
+        _scalar_value& operator=(const _scalar_value& other)
+        {
+            if (this != &other) {
+                if (_has_string() && other._has_string()) {
+                    string() = other.string();
+                    m_type = other.m_type;
+                    m_raw = static_cast<bool>(other.m_raw);
+                    return *this;
+                }
+                _destroy();
+                _copy(other);
+                m_type = other.m_type;
+            }
+            return *this;
         }
 
-        virtual void lookupValue(unsigned int&) {
-            throw _type_ex("converion not implemented");
+        ~_scalar_value()
+        {
+            _destroy();
         }
 
-        virtual void lookupValue(long&) {
-            throw _type_ex("converion not implemented");
+        bool operator==(const _scalar_value& other) const
+        {
+            if (m_type != other.m_type) {
+                return false;
+            }
+            resolve();
+            other.resolve();
+            switch(m_type) {
+            case TypeBoolean:
+                return m_bool == other.m_bool;
+            case TypeInt:
+                return m_int == other.m_int;
+            case TypeFloat:
+                return m_float == other.m_float;
+            case TypeString:
+                return string() == other.string();
+            default:
+                return m_long == other.m_long;
+            }
         }
 
-        virtual void assignValue(long) {
-            throw _type_ex("converion not supported");
-
+        Type type() const
+        {
+            return m_type;
         }
 
-        virtual void lookupValue(unsigned long&) {
-            throw _type_ex("converion not implemented");
+        void swap(_scalar_value& other)
+        {
+            if (_has_string() && other._has_string()) {
+                string().swap(other.string());
+                std::swap(m_type, other.m_type);
+                bool raw = m_raw;
+                m_raw = static_cast<bool>(other.m_raw);
+                other.m_raw = raw;
+            } else {
+                _scalar_value copy(other);
+                other = *this;
+                *this = copy;
+            }
         }
 
-        virtual void lookupValue(float&) {
-            throw _type_ex("converion not implemented");
+        /*!
+         * \brief keeps text as the value of a number until it is accessed
+         * \param text number as read by the parser, classified as type()
+         */
+        void setText(const string_type& text)
+        {
+            BOOST_ASSERT(m_type != TypeString);
+            if (!m_raw) {
+                new (m_string) string_type();
+                m_raw = true;
+            }
+            string() = text;
         }
 
-        virtual void assignValue(float) {
-            throw _type_ex("converion not supported");
-
-        }
-
-        virtual void lookupValue(double&) {
-            throw _type_ex("converion not implemented");
-        }
-
-        virtual void lookupValue(string_type&) {
-            throw _type_ex("converion not implemented");
-        }
-
-        virtual void assignValue(const string_type&) {
-            throw _type_ex("converion not supported");
-
-        }
-
-        virtual basic_setting& at(const string_type& property)
+        /*!
+         * \brief converts text kept by setText() to the value
+         *
+         * Const reads may convert the same value from several threads, the
+         * first one converts under the mutex of the value.
+         */
+        void resolve() const
         {
-            throw _not_found_ex(property);
+            if (m_raw) {
+#ifdef LIBCONFIGPP_HAS_THREADS
+                std::lock_guard<std::mutex> lock(_mutex());
+                if (!m_raw) {
+                    return;
+                }
+#endif
+                const_cast<_scalar_value*>(this)->_convert();
+            }
         }
 
-        virtual basic_setting& at(size_t index)
+        bool& boolean()
         {
-            throw _not_found_ex(index);
+            resolve();
+            return m_bool;
         }
 
-        virtual bool exists(size_t index) const
+        bool boolean() const
         {
-            return false;
+            resolve();
+            return m_bool;
         }
 
-        virtual bool exists(const string_type &path) const
+        int& integer()
         {
-            return false;
+            resolve();
+            return m_int;
         }
 
-        virtual basic_setting& add(const basic_setting&)
+        int integer() const
         {
-            throw ConfigException("operation not supported");
+            resolve();
+            return m_int;
         }
 
-        virtual void remove(const string_type& property)
+        long& integer64()
         {
-            throw _not_found_ex(property);
+            resolve();
+            return m_long;
         }
 
-        virtual void remove(size_t index)
+        long integer64() const
         {
-            throw _not_found_ex(index);
+            resolve();
+            return m_long;
         }
 
-        virtual int indexOf(const basic_setting &child) const
+        float& floating()
         {
-            return -1;
+            resolve();
+            return m_float;
         }
 
-        virtual size_t size() const
+        float floating() const
         {
-            return 0;
+            resolve();
+            return m_float;
         }
 
-        virtual Format format() const
+        string_type& string()
         {
-            return FormatDefault;
+            return *reinterpret_cast<string_type*>(m_string);
         }
 
-        virtual void set_format(Format)
+        const string_type& string() const
         {
-
+            return *reinterpret_cast<const string_type*>(m_string);
         }
-    };
-
-    class _basic_setting_list : public _basic_setting
-    {
-    protected:
-        _basic_setting_list(const _basic_setting_list&) {}
-        _basic_setting_list& operator=(const _basic_setting_list& other)
-        { return *this; }
-
-    public:
-        typedef basic_setting<char_type> value_type;
-        typedef boost::shared_ptr<value_type> value_ptr;
-        friend class basic_config<char_type>;
 
-        _basic_setting_list(basic_setting* container,
-                            const std::vector<value_type>& values = std::vector<value_type>())
-            : m_container(container),
-              rx_index("$\\[\\d+\\](\\..+)?")
+    private:
+        bool _has_string() const
         {
-            for(size_t i=0; i<values.size(); i++) {
-                value_ptr value(new value_type(values[i]));
-                value->m_parent = container;
-                m_properties.push_back(value);
-            }
+            return m_type == TypeString || m_raw;
         }
 
-        virtual ~_basic_setting_list() {}
-
-        virtual _basic_setting* clone(basic_setting *new_container)
+        void _destroy()
         {
-            _basic_setting_list* item = new _basic_setting_list(new_container);
-            for(size_t i=0; i<m_properties.size(); i++) {
-                item->add(*m_properties[i]);
+            if (_has_string()) {
+                string().~string_type();
+                m_raw = false;
             }
-            return item;
         }
 
-        bool operator==(const _basic_setting& other) const
+        void _copy(const _scalar_value& other)
         {
-            const _basic_setting_list& o = static_cast<const _basic_setting_list&>(other);
-
-            if(m_properties.size() == o.m_properties.size()) {
-                for(size_t i=0; i<m_properties.size(); i++) {
-                    if (!(*m_properties[i] == *o.m_properties[i])) {
-                        return false;
-                    }
+            if (other.m_raw) {
+#ifdef LIBCONFIGPP_HAS_THREADS
+                std::lock_guard<std::mutex> lock(other._mutex());
+#endif
+                if (other.m_raw) {
+                    new (m_string) string_type(other.string());
+                    m_raw = true;
+                    return;
                 }
-                return true;
             }
-            return false;
-        }
-
-        virtual void print(std::ostream& o, size_t level) const
-        {
-            string_type ident_p(level * 4, ' ');
-            string_type ident_c((level+1) * 4, ' ');
-            if(m_properties.empty()) {
-                o << "()";
-            } else {
-                o << "(\n";
-                for(size_t i=0; i<m_properties.size(); i++) {
-                    if (i > 0)
-                        o << ident_c << ",\n";
-                    o << ident_c;
-                    m_properties[i]->print(o, level+1);
-                    o << "\n";
-                }
-                o << ident_p << ")";
+            switch(other.m_type) {
+            case TypeBoolean:
+                m_bool = other.m_bool;
+                break;
+            case TypeInt:
+                m_int = other.m_int;
+                break;
+            case TypeFloat:
+                m_float = other.m_float;
+                break;
+            case TypeString:
+                new (m_string) string_type(other.string());
+                break;
+            default:
+                m_long = other.m_long;
             }
         }
 
-        basic_setting& at(size_t index)
+        /*!
+         * \brief replaces the text by the value, m_raw is cleared last so
+         * that readers which see it cleared without locking find the value
+         */
+        void _convert()
         {
-            if(index >= m_properties.size()) {
-                throw _not_found_ex(index);
+            string_type text;
+            text.swap(string());
+            string().~string_type();
+
+            bool hex = text.size() > 1 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
+            long integer;
+            switch(m_type) {
+            case TypeBoolean:
+                m_bool = text.size() == 4 && (text[0] == 't' || text[0] == 'T');
+                break;
+            case TypeInt:
+                _parse(text, hex, integer);
+                integer = std::min<long>(integer, std::numeric_limits<int>::max());
+                m_int = static_cast<int>(std::max<long>(integer, std::numeric_limits<int>::min()));
+                break;
+            case TypeFloat:
+                _parse(text, m_float);
+                break;
+            default:
+                _parse(text, hex, m_long);
             }
-            return *m_properties[index];
+            m_raw = false;
         }
 
-        bool exists(size_t index) const
+#ifdef LIBCONFIGPP_HAS_THREADS
+        /*!
+         * \brief returns the mutex guarding the conversion of this value
+         *
+         * Only values still holding text lock it, and each only until it is
+         * converted, so values share a few mutexes by address.
+         */
+        std::mutex& _mutex() const
         {
-            return index < m_properties.size();
+            static std::mutex mutexes[16];
+            return mutexes[reinterpret_cast<size_t>(this) / sizeof(_scalar_value) % 16];
         }
+#endif
 
-        virtual basic_setting& add(const basic_setting& value)
+        /*!
+         * \brief converts narrow text with the C library, no stream is set up
+         */
+        static void _parse(const std::string& text, bool hex, long& value)
         {
-            value_ptr v(new value_type(value));
-            v->m_parent = m_container;
-            m_properties.push_back(v);
-            return *m_properties.back();
+            value = std::strtol(text.c_str(), 0, hex ? 16 : 10);
         }
 
-        void remove(size_t index)
+#ifdef LIBCONFIGPP_HAS_FROM_CHARS
+        /*!
+         * \brief converts narrow text without a stream; unlike strtod this ignores LC_NUMERIC
+         */
+        static void _parse(const std::string& text, float& value)
         {
-            if(index >= m_properties.size()) {
-                throw _not_found_ex(index);
+            const char* first = text.data();
+            const char* last = first + text.size();
+            if (first != last && *first == '+') {
+                ++first;        // from_chars takes no plus sign
             }
-            m_properties.erase(m_properties.begin() + index);
+            value = 0;
+            std::from_chars(first, last, value);
         }
+#endif
 
-        int indexOf(const basic_setting &child) const
+        template<typename String>
+        static void _parse(const String& text, bool hex, long& value)
         {
-            typename std::vector<value_ptr>::const_iterator it=m_properties.begin();
-            for(int index = 0; it != m_properties.end(); ++it, index++)
-            {
-                if (child == **it)
-                    return index;
+            std::basic_istringstream<typename String::value_type> iss(text);
+            iss.imbue(std::locale::classic());
+            if (hex) {
+                iss >> std::hex;
             }
-            return -1;
+            value = 0;
+            iss >> value;
         }
 
-        size_t size() const
+        template<typename String>
+        static void _parse(const String& text, float& value)
         {
-            return m_properties.size();
-        }
-
-    protected:
-        basic_setting* m_container;
-        std::vector<value_ptr> m_properties;
-        boost::regex rx_index;
+            std::basic_istringstream<typename String::value_type> iss(text);
+            iss.imbue(std::locale::classic());
+            value = 0;
+            iss >> value;
+        }
+
+        Type m_type;
+#ifdef LIBCONFIGPP_HAS_THREADS
+        std::atomic<bool> m_raw;    //!< the union holds the text of a number, not its value
+#else
+        bool m_raw;     //!< the union holds the text of a number, not its value
+#endif
+        union {
+            bool m_bool;
+            int m_int;
+            long m_long;
+            float m_float;
+            char m_string[sizeof(string_type)];
+            typename boost::type_with_alignment<
+                boost::alignment_of<string_type>::value>::type m_align;
+        };
     };
 
-    class _basic_setting_array : public _basic_setting_list
+    /*!
+     * \brief elements of an array packed into one vector of their type
+     *
+     * Only the vector matching element is used. Formats are only stored
+     * once an element is not in the default format.
+     */
+    struct _packed_array
     {
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+        explicit _packed_array(std::pmr::memory_resource* memory)
+            : element(TypeInt),
+              reserved(0),
+              booleans(memory),
+              integers(memory),
+              integers64(memory),
+              floats(memory),
+              strings(memory),
+              formats(memory)
+        {}
+#else
+        _packed_array()
+            : element(TypeInt),
+              reserved(0)
+        {}
+#endif
 
-    public:
-        typedef basic_setting<char_type> value_type;
-
-        _basic_setting_array(basic_setting* container,
-                             const std::vector<value_type>& values = std::vector<value_type>())
-            : _basic_setting_list(container, values),
-              m_type(TypeArray)
+        size_t size() const
         {
-            if (!values.empty()) {
-                if (!values.front().isScalar()) {
-                    throw _type_ex("Array elements must be scalar values");
-                }
-                m_type = values.front().getType();
-            }
-
-            for(size_t i=1; i<values.size(); i++) {
-                if (values[i].getType() != m_type) {
-                    throw _type_ex("Array elements do not have same type");
-                }
+            switch(element) {
+            case TypeBoolean:
+                return booleans.size();
+            case TypeInt:
+                return integers.size();
+            case TypeInt64:
+                return integers64.size();
+            case TypeFloat:
+                return floats.size();
+            default:
+                return strings.size();
             }
         }
 
-        _basic_setting* clone(basic_setting *new_container)
+        void push_back(const _scalar_value& value, Format format)
         {
-            _basic_setting_array* item = new _basic_setting_array(new_container);
-            for(size_t i=0; i<this->m_properties.size(); i++) {
-                item->add(*this->m_properties[i]);
+            if (size() == 0) {
+                element = value.type();
+                _reserve(reserved);
+            }
+            switch(element) {
+            case TypeBoolean:
+                booleans.push_back(value.boolean());
+                break;
+            case TypeInt:
+                integers.push_back(value.integer());
+                break;
+            case TypeInt64:
+                integers64.push_back(value.integer64());
+                break;
+            case TypeFloat:
+                floats.push_back(value.floating());
+                break;
+            default:
+                strings.push_back(value.string());
+            }
+            if (format != FormatDefault || !formats.empty()) {
+                formats.resize(size() - 1, FormatDefault);
+                formats.push_back(format);
             }
-            return item;
         }
 
-        basic_setting& add(const basic_setting& value)
+        /*!
+         * \brief appends value, which must be of type element unless the
+         * array is empty, without going through a _scalar_value
+         */
+        template<typename T>
+        void push_back(Type type, const T& value)
         {
-            if(!value.isScalar()) {
-                throw _type_ex("Array elements must be scalar values");
+            if (size() == 0) {
+                element = type;
+                _reserve(reserved);
             }
-            if (this->size() != 0 && this->at(0).getType() != value.getType()) {
-                throw _type_ex("Array elements must have same type");
+            _values(value).push_back(value);
+            if (!formats.empty()) {
+                formats.push_back(FormatDefault);
             }
-            return _basic_setting_list::add(value);
         }
 
-        void print(std::ostream& o, size_t) const
+        /*!
+         * \brief replaces the elements with the values in [first, last)
+         */
+        template<typename Iterator>
+        void assign(Type type, Iterator first, Iterator last)
         {
-            o << "[";
-            for(size_t i = 0; i < this->m_properties.size(); i++) {
-                if (i>0)
-                    o  << ", ";
-                this->m_properties[i]->print(o, 0);
-            }
-            o << "]";
+            clear();
+            element = type;
+            typedef typename std::iterator_traits<Iterator>::value_type value_type;
+            _values(value_type()).assign(first, last);
         }
 
-    private:
-        typename value_type::Type m_type;
-    };
-
-    class _basic_setting_container : public _basic_setting
-    {
-        _basic_setting_container(const _basic_setting_container&) {}
-        _basic_setting_container& operator =(const _basic_setting_container&)
-        { return *this; }
-
-    public:
-        typedef basic_setting<char_type> value_type;
-        typedef boost::shared_ptr<value_type> value_ptr;
-
-        _basic_setting_container(basic_setting* container)
-            : m_container(container)
+        /*!
+         * \brief reserves room for count elements, applied to the vector of
+         * the element type once the first element is added
+         */
+        void reserve(size_t count)
         {
+            reserved = count;
+            if (size()) {
+                _reserve(count);
+            }
         }
 
-        bool operator==(const _basic_setting& other) const
+        void store(size_t index, const _scalar_value& value, Format format)
         {
-            const _basic_setting_container& o = static_cast<const _basic_setting_container&>(other);
-
-            if(m_mapping.size() == o.m_mapping.size()) {
-                typename std::map<string_type, value_ptr>::const_iterator lhs = m_mapping.begin();
-                typename std::map<string_type, value_ptr>::const_iterator rhs = o.m_mapping.begin();
-                for(; lhs != m_mapping.end(); ++lhs, ++rhs) {
-                    if(!(*lhs->second == *rhs->second)) {
-                        return false;
-                    }
-                }
-                return true;
+            switch(element) {
+            case TypeBoolean:
+                booleans[index] = value.boolean();
+                break;
+            case TypeInt:
+                integers[index] = value.integer();
+                break;
+            case TypeInt64:
+                integers64[index] = value.integer64();
+                break;
+            case TypeFloat:
+                floats[index] = value.floating();
+                break;
+            default:
+                strings[index] = value.string();
+            }
+            if (format != FormatDefault || !formats.empty()) {
+                formats.resize(size(), FormatDefault);
+                formats[index] = format;
             }
-            return false;
         }
 
-        void print(std::ostream& o, size_t level) const
+        /*!
+         * \brief copies an element into value, which must be of type element
+         */
+        void load(size_t index, _scalar_value& value) const
         {
-            bool complex = m_container->m_parent || !m_container->m_name.empty();
-            string_type ident_p(level * 4, ' ');
-            size_t level_c = complex ? level + 1 : level;
-            string_type ident_c(level_c * 4, ' ');
-
-            if(m_mapping.empty()) {
-                o << "{}";
-            } else {
-                if (complex)
-                    o << "{\n";
-
-                typename std::map<string_type, value_ptr>::const_iterator it = m_mapping.begin();
-                for(; it != m_mapping.end(); ++it)
-                {
-                    o << ident_c;
-                    it->second->print(o, level_c);
-                    o << ";\n";
-                }
-                if (complex)
-                    o << ident_p << "}";
+            switch(element) {
+            case TypeBoolean:
+                value.boolean() = booleans[index];
+                break;
+            case TypeInt:
+                value.integer() = integers[index];
+                break;
+            case TypeInt64:
+                value.integer64() = integers64[index];
+                break;
+            case TypeFloat:
+                value.floating() = floats[index];
+                break;
+            default:
+                value.string() = strings[index];
             }
         }
 
-        _basic_setting* clone(basic_setting *new_container)
+        Format format(size_t index) const
         {
-            _basic_setting_container* item = new _basic_setting_container(new_container);
-            typename std::map<string_type, value_ptr>::iterator it = m_mapping.begin();
-            for (; it != m_mapping.end(); ++it) {
-                item->add(*it->second);
-            }
-            return item;
+            return index < formats.size() ? formats[index] : FormatDefault;
         }
 
-        basic_setting& at(const string_type &property)
+        void erase(size_t index)
         {
-            if(m_mapping.count(property)) {
-                return *m_mapping.at(property);
+            switch(element) {
+            case TypeBoolean:
+                booleans.erase(booleans.begin() + index);
+                break;
+            case TypeInt:
+                integers.erase(integers.begin() + index);
+                break;
+            case TypeInt64:
+                integers64.erase(integers64.begin() + index);
+                break;
+            case TypeFloat:
+                floats.erase(floats.begin() + index);
+                break;
+            default:
+                strings.erase(strings.begin() + index);
+            }
+            if (index < formats.size()) {
+                formats.erase(formats.begin() + index);
             }
-            throw _not_found_ex(property);
         }
 
-        basic_setting& at(size_t index)
+        bool operator==(const _packed_array& other) const
         {
-            if(index < m_mapping.size()) {
-
-                size_t counter = 0;
-                typename std::map<string_type, value_ptr>::iterator it = m_mapping.begin();
+            if (size() != other.size()) {
+                return false;
+            }
+            // unused vectors are empty on both sides
+            return size() == 0 || (element == other.element &&
+                                   booleans == other.booleans &&
+                                   integers == other.integers &&
+                                   integers64 == other.integers64 &&
+                                   floats == other.floats &&
+                                   strings == other.strings);
+        }
 
-                for(; it != m_mapping.end() && counter < index; ++it)
-                    counter++;
+        void clear()
+        {
+            booleans.clear();
+            integers.clear();
+            integers64.clear();
+            floats.clear();
+            strings.clear();
+            formats.clear();
+        }
+
+        Type element;
+        size_t reserved;        //!< capacity requested by reserve()
+        typename _list<bool>::type booleans;
+        typename _list<int>::type integers;
+        typename _list<long>::type integers64;
+        typename _list<float>::type floats;
+        typename _list<string_type>::type strings;
+        typename _list<Format>::type formats;
 
-                return *it->second;
+    private:
+        void _reserve(size_t count)
+        {
+            switch(element) {
+            case TypeBoolean:
+                booleans.reserve(count);
+                break;
+            case TypeInt:
+                integers.reserve(count);
+                break;
+            case TypeInt64:
+                integers64.reserve(count);
+                break;
+            case TypeFloat:
+                floats.reserve(count);
+                break;
+            default:
+                strings.reserve(count);
             }
-
-            throw _not_found_ex(index);
         }
 
-        bool exists(size_t index) const
+        typename _list<bool>::type& _values(bool)
         {
-            return index < m_mapping.size();
+            return booleans;
         }
 
-        bool exists(const string_type& property) const
+        typename _list<int>::type& _values(int)
         {
-            return m_mapping.count(property);
+            return integers;
         }
 
-        basic_setting& add(const basic_setting& value)
+        typename _list<long>::type& _values(long)
         {
-            if (m_mapping.count(value.getName())) {
-                throw _name_ex(value.getName() + " already exists");
-            }
-            value_ptr v(new value_type(value));
-            v->m_parent = m_container;
-            m_mapping.insert(std::make_pair(value.getName(), v));
-            return *v;
+            return integers64;
         }
 
-        void remove(const string_type &property)
+        typename _list<float>::type& _values(float)
         {
-            if (m_mapping.count(property)) {
-                m_mapping.erase(property);
-            } else {
-                throw _not_found_ex(property);
-            }
+            return floats;
         }
 
-        void remove(size_t index)
+        typename _list<float>::type& _values(double)
         {
-            const basic_setting& setting = at(index);
-            m_mapping.erase(setting.getName());
+            return floats;
         }
 
-        int indexOf(const basic_setting &child) const
+        typename _list<string_type>::type& _values(const string_type&)
         {
-            typename std::map<string_type, value_ptr>::const_iterator it=m_mapping.begin();
-            for(int index = 0; it != m_mapping.end(); ++it, index++)
-            {
-                if (child == *it->second)
-                    return index;
-            }
-            return -1;
+            return strings;
         }
 
-        size_t size() const
+        typename _list<string_type>::type& _values(const char_type*)
         {
-            return m_mapping.size();
+            return strings;
         }
-
-        basic_setting* m_container;
-        std::map<string_type, value_ptr> m_mapping;
     };
 
-    template<typename T>
-    class _basic_setting_scalar : public _basic_setting
+    /*!
+     * \brief children of a group, list or array in insertion order
+     *
+     * Groups with more than index_threshold members also keep an open
+     * addressing hash index from atoms to positions, smaller ones are
+     * searched linearly. Lists and arrays have no names to index. Arrays
+     * keep their elements in packed instead of items; a setting for an
+     * element is only created when the element is accessed and is kept in
+     * elements, its changes are written through to packed right away.
+     *
+     * A loader set by defer() creates the children on first access. Const
+     * reads may run it from several threads, so it runs under mutex and
+     * deferred is cleared only once the children are complete. The loader
+     * stays set while it runs, copies made meanwhile take it over.
+     *
+     * A copy of a setting does not copy the children right away. Its list
+     * is linked to the list of the original as source and copies one level
+     * of children on first access. Before the original or one of its
+     * descendants changes, the pending copies fill themselves, so they
+     * keep the state the original had when it was copied. The links to the
+     * lists of a tree are guarded by the copy guard of its atom table.
+     */
+    struct _children
     {
-        _basic_setting_scalar(const _basic_setting_scalar& other)
-            : m_value(other.m_value),
-              m_format(other.format())
-        {
-        }
-
-    public:
-        _basic_setting_scalar()
-            : m_value(T()),
-              m_format(FormatDefault)
-        {}
+        enum {
+            index_threshold = 8
+        };
 
-        _basic_setting_scalar(const T& value)
-            : m_value(value),
-              m_format(FormatDefault)
+        _children(atom_table* _atoms, bool _keyed)
+            : keyed(_keyed),
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+              items(_atoms->lists()),
+              index(_atoms->lists()),
+              packed(_atoms->lists()),
+              elements(_atoms->lists()),
+#endif
+              deferred(false),
+              loading(false),
+              atoms(_atoms),
+              owner(0),
+              source(0)
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+              , copies(_atoms->lists())
+#endif
         {}
 
-        _basic_setting* clone(basic_setting *new_container)
+        ~_children()
         {
-            return new _basic_setting_scalar(*this);
+            detach_copies();
+            if (source) {
+#ifdef LIBCONFIGPP_HAS_THREADS
+                std::lock_guard<std::recursive_mutex> lock(guard->mutex);
+#endif
+                if (source) {
+                    unlink();
+                }
+            }
         }
 
-        bool operator==(const _basic_setting& other) const
+        /*!
+         * \brief returns the position of the member named atom or items.size()
+         */
+        size_t find(atom_type atom) const
         {
-            const _basic_setting_scalar<T>& o = static_cast<const _basic_setting_scalar<T>& >(other);
-
-            const T& lhs = boost::any_cast<const T&>(m_value);
-            const T& rhs = boost::any_cast<const T&>(o.m_value);
-
-            return lhs == rhs;
+            if (index.empty()) {
+                for (size_t i = 0; i < items.size(); i++) {
+                    if (items[i]->m_name == atom) {
+                        return i;
+                    }
+                }
+                return items.size();
+            }
+            size_t mask = index.size() - 1;
+            for (size_t slot = _hash(atom) & mask; index[slot]; slot = (slot + 1) & mask) {
+                if (items[index[slot] - 1]->m_name == atom) {
+                    return index[slot] - 1;
+                }
+            }
+            return items.size();
         }
 
-        void print(std::ostream& o, size_t) const
+        /*!
+         * \brief appends a group member and indexes it
+         */
+        void push_back(const value_ptr& v)
         {
-            Type type = _deduce_scalar_type(T());
-            if ((type == TypeInt || type == TypeInt64) && m_format == FormatHex) {
-                o << "0x" << std::hex;
+            v->m_position = items.size();
+            items.push_back(v);
+            if (!keyed || items.size() <= index_threshold) {
+                return;
+            } else if (items.size() * 2 > index.size()) {
+                reindex();
+            } else {
+                _insert(items.size() - 1);
             }
+        }
 
-            switch(type)
-            {
-            case TypeInt64:
-                o << boost::any_cast<T>(m_value) << "L";
-                break;
-            case TypeString:
-                o << '"' << boost::any_cast<T>(m_value) << '"';
-                break;
-            default:
-                o << boost::any_cast<T>(m_value);
+        /*!
+         * \brief removes a child, the children behind it move up
+         */
+        void erase(size_t position)
+        {
+            items.erase(items.begin() + position);
+            for (size_t i = position; i < items.size(); i++) {
+                items[i]->m_position = i;
             }
-
-            o << std::dec;
+            reindex();
         }
 
-        void lookupValue(bool& result)
+        /*!
+         * \brief rebuilds the index after members were moved or removed
+         */
+        void reindex()
         {
-            switch(_deduce_scalar_type(T())) {
-            case TypeBoolean:
-            case TypeInt:
-            case TypeInt64:
-            {
-                long t;
-                lookupValue(t);
-                result = t != 0;
-                break;
+            index.clear();
+            if (!keyed || items.size() <= index_threshold) {
+                return;
             }
-            case TypeFloat:
-            {
-                float t = boost::any_cast<float>(m_value);
-                result = t != 0;
-                break;
+            size_t capacity = 2 * index_threshold;
+            while (capacity < items.size() * 4) {
+                capacity *= 2;
             }
-            default:
-                throw _type_ex("unsupported conversion");
+            index.assign(capacity, 0);
+            for (size_t i = 0; i < items.size(); i++) {
+                _insert(i);
             }
         }
 
-        void assignValue(bool value)
+        /*!
+         * \brief removes an array element, the elements behind it move up
+         */
+        void erase_element(size_t position)
         {
-            switch(_deduce_scalar_type(T())) {
-            case TypeBoolean:
-                m_value = boost::any(value);
-                break;
-            case TypeInt:
-                m_value = boost::any(1);
-                break;
-            case TypeInt64:
-                m_value = boost::any(1L);
-                break;
-            default:
-                throw _type_ex("Conversion not possible");
-            }
-        }
-
-        void lookupValue(int& result)
-        {
-            switch(_deduce_scalar_type(T())) {
-            case TypeBoolean:
-            case TypeInt:
-            case TypeInt64:
-            {
-                long t;
-                lookupValue(t);
-
-                if(t > std::numeric_limits<int>::max() || t < std::numeric_limits<int>::min()) {
-                    throw _type_ex("type overflow");
+            packed.erase(position);
+            element_map moved(elements.bucket_count(), elements.hash_function(),
+                              elements.key_eq(), elements.get_allocator());
+            typename element_map::const_iterator it;
+            for (it = elements.begin(); it != elements.end(); ++it) {
+                if (it->first < position) {
+                    moved.insert(*it);
+                } else if (it->first > position) {
+                    it->second->m_position = it->first - 1;
+                    moved.insert(std::make_pair(it->first - 1, it->second));
                 }
-                result = t;
-                break;
-            }
-            default:
-                throw _type_ex("unsupported conversion");
             }
+            elements.swap(moved);
         }
 
-        void assignValue(int value)
+        void clear()
         {
-            switch(_deduce_scalar_type(T())) {
-            case TypeBoolean:
-                m_value = boost::any(static_cast<bool>(value));
-                break;
-            case TypeInt:
-                m_value = boost::any(value);
-                break;
-            case TypeInt64:
-                m_value = boost::any(static_cast<long>(value));
-                break;
-            case TypeFloat:
-                m_value = boost::any(static_cast<float>(value));
-                break;
-            default:
-                throw _type_ex("Conversion not possible");
-            }
+            items.clear();
+            index.clear();
+            packed.clear();
+            elements.clear();
         }
 
-        void lookupValue(unsigned int& result)
+        /*!
+         * \brief makes this list a pending copy of from, or a deferred one
+         * if the loader of from did not finish yet
+         */
+        void link(_children* from)
         {
-            switch(_deduce_scalar_type(T())) {
-            case TypeBoolean:
-            case TypeInt:
-            case TypeInt64:
-            {
-                long t;
-                lookupValue(t);
-                if(t < 0) {
-                    throw _type_ex("negative value");
-                } else if (t > std::numeric_limits<unsigned int>::max()) {
-                    throw _type_ex("type overflow");
-                }
-                result = t;
-                break;
+            if (share_source(from)) {
+                return;
             }
-            default:
-                throw _type_ex("unsupported conversion");
+            const boost::shared_ptr<copy_guard>& tree = from->atoms->copies();
+#ifdef LIBCONFIGPP_HAS_THREADS
+            std::lock_guard<std::recursive_mutex> lock(tree->mutex);
+#endif
+            if (from->loader) {
+                set_loader(from->loader);
+            } else {
+                _attach(from, tree);
             }
         }
 
-        void lookupValue(long& result)
+        void set_loader(const loader_type& _loader)
         {
-            switch(_deduce_scalar_type(T())) {
-            case TypeBoolean:
-            {
-                bool t = boost::any_cast<bool>(m_value);
-                if (t) {
-                    result = 1;
-                } else {
-                    result = 0;
-                }
-                break;
-            }
-            case TypeInt:
-                result = boost::any_cast<int>(m_value);
-                break;
-            case TypeInt64:
-                result = boost::any_cast<long>(m_value);
-                break;
-            default:
-                throw _type_ex("unsupported conversion");
-            }
+            loader = _loader;
+            deferred = true;
         }
 
-        void assignValue(long value)
+        /*!
+         * \brief drops the loader once the children are complete
+         *
+         * Copies read the loader under the mutex of the copy guard, so it
+         * is cleared under that mutex as well.
+         */
+        void loaded()
         {
-            switch(_deduce_scalar_type(T())) {
-            case TypeBoolean:
-                m_value = boost::any(static_cast<bool>(value));
-                break;
-            case TypeInt:
-                m_value = boost::any(static_cast<int>(value));
-                break;
-            case TypeInt64:
-                m_value = boost::any(value);
-                break;
-            case TypeFloat:
-                m_value = boost::any(static_cast<float>(value));
-                break;
-            default:
-                throw _type_ex("Conversion not possible");
-            }
+#ifdef LIBCONFIGPP_HAS_THREADS
+            std::lock_guard<std::recursive_mutex> lock(atoms->copies()->mutex);
+#endif
+            loader = loader_type();
+            loading = false;
+            deferred = false;
         }
 
-        void lookupValue(unsigned long& result)
+        /*!
+         * \brief makes this list a pending copy of the source of from
+         * \return false if from is not a pending copy
+         */
+        bool share_source(_children* from)
         {
-            switch(_deduce_scalar_type(T())) {
-            case TypeBoolean:
-            case TypeInt:
-            case TypeInt64:
-            {
-                long t;
-                lookupValue(t);
-                if (t >= 0) {
-                    result = t;
-                } else {
-                    throw _type_ex("negative value");
-                }
-                break;
+            if (!from->source) {
+                return false;
             }
-            default:
-                throw _type_ex("unsupported conversion");
+#ifdef LIBCONFIGPP_HAS_THREADS
+            std::lock_guard<std::recursive_mutex> lock(from->guard->mutex);
+#endif
+            if (!from->source) {
+                return false;
             }
+            _attach(from->source, from->guard);
+            return true;
         }
 
-        void lookupValue(float& result)
+        /*!
+         * \brief copies one level of children from source, the grandchildren
+         * become pending copies in turn
+         *
+         * Copies of one source are filled by whichever thread reads them
+         * first, so the lists of the source are only changed under the
+         * mutex of its copy guard. source is cleared last: a reader that
+         * sees it cleared without taking the mutex finds the children
+         * complete.
+         */
+        void fill()
         {
-            switch(_deduce_scalar_type(T())) {
-            case TypeBoolean:
-            case TypeInt:
-            case TypeInt64:
-            {
-                long t;
-                lookupValue(t);
-                result = t;
-                break;
+            if (!source) {
+                return;
             }
-            case TypeFloat:
-                result = boost::any_cast<float>(m_value);
-                break;
-            default:
-                throw _type_ex("unsupported conversion");
+#ifdef LIBCONFIGPP_HAS_THREADS
+            std::lock_guard<std::recursive_mutex> lock(guard->mutex);
+#endif
+            _children* from = source;
+            if (!from) {
+                return;
             }
-        }
-
-        void assignValue(float value)
-        {
-            switch(_deduce_scalar_type(T())) {
-            case TypeInt:
-                m_value = boost::any(static_cast<int>(value));
-                break;
-            case TypeInt64:
-                m_value = boost::any(static_cast<long>(value));
-                break;
-            case TypeFloat:
-                m_value = boost::any(value);
-                break;
-            default:
-                throw _type_ex("Conversion not possible");
+            if (from->loader) {
+                set_loader(from->loader);
+                unlink();
+                return;
+            }
+            const value_array& other = from->items;
+            try {
+                items.reserve(other.size());
+                for (size_t i = 0; i < other.size(); i++) {
+                    value_ptr v(owner->_make_node(*other[i]));
+                    v->m_parent = owner;
+                    v->m_position = i;
+                    items.push_back(v);
+                }
+                reindex();
+                packed = from->packed;
+            } catch (...) {
+                items.clear();
+                index.clear();
+                throw;
             }
+            unlink();
         }
 
-        void lookupValue(double& result)
+        /*!
+         * \brief fills all pending copies of this list
+         */
+        void detach_copies()
         {
-            switch(_deduce_scalar_type(T())) {
-            case TypeBoolean:
-            case TypeInt:
-            case TypeInt64:
-            case TypeFloat:
-                float t;
-                lookupValue(t);
-                result = t;
-                break;
-            default:
-                throw _type_ex("unsupported conversion");
+            copy_guard& tree = *atoms->copies();
+            if (!tree.pending) {
+                return;
+            }
+#ifdef LIBCONFIGPP_HAS_THREADS
+            std::lock_guard<std::recursive_mutex> lock(tree.mutex);
+#endif
+            while (!copies.empty()) {
+                copies.back()->fill();
             }
         }
 
-        void lookupValue(string_type& result)
+        bool keyed;                 //!< the children are group members, looked up by name
+        value_array items;
+        typename _list<size_t>::type index; //!< positions + 1, 0 marks an empty slot
+        _packed_array packed;
+        element_map elements;       //!< array elements accessed as settings, by position
+        loader_type loader;
+#ifdef LIBCONFIGPP_HAS_THREADS
+        std::recursive_mutex mutex; //!< guards elements and the loader, which const reads use
+        std::atomic<bool> deferred; //!< loader is set, read without locking
+#else
+        bool deferred;
+#endif
+        bool loading;               //!< the loader is running
+        atom_table* atoms;          //!< table of the tree, its copy guard guards copies
+        basic_setting* owner;       //!< setting the children belong to
+#ifdef LIBCONFIGPP_HAS_THREADS
+        std::atomic<_children*> source;     //!< list to copy the children from, 0 once copied
+#else
+        _children* source;
+#endif
+        boost::shared_ptr<copy_guard> guard;    //!< copy guard of the tree of source
+        typename _list<_children*>::type copies;    //!< lists with this one as source
+
+    private:
+        /*!
+         * \brief links this list to root, the mutex of tree must be held
+         */
+        void _attach(_children* root, const boost::shared_ptr<copy_guard>& tree)
         {
-            switch(_deduce_scalar_type(T()))
-            {
-            case TypeString:
-                result = boost::any_cast<string_type>(m_value);
-                break;
-            default:
-                throw _type_ex("unsupported conversion");
-            }
+            root->copies.push_back(this);
+            tree->pending++;
+            guard = tree;
+            source = root;
         }
 
-        void assignValue(const string_type& value)
+        /*!
+         * \brief removes this list from the copies of its source, the mutex
+         * of guard must be held
+         */
+        void unlink()
         {
-            switch(_deduce_scalar_type(T())) {
-            case TypeString:
-                m_value = boost::any(value);
-                break;
-            default:
-                throw _type_ex("Conversion not possible");
-            }
+            _children* from = source;
+            typename _list<_children*>::type& pending = from->copies;
+            pending.erase(std::find(pending.begin(), pending.end(), this));
+            guard->pending--;
+            source = 0;
         }
 
-        Format format() const
+        static size_t _hash(atom_type atom)
         {
-            return m_format;
+            // atoms are dense, a multiplicative hash spreads them over the slots
+            return static_cast<size_t>(atom) * 2654435761u;
         }
 
-        void set_format(Format f)
+        void _insert(size_t position)
         {
-            m_format = f;
+            size_t mask = index.size() - 1;
+            size_t slot = _hash(items[position]->m_name) & mask;
+            while (index[slot]) {
+                slot = (slot + 1) & mask;
+            }
+            index[slot] = position + 1;
         }
-
-        boost::any m_value;
-        Format m_format;
     };
 
-    static void _check_path(const string_type& path)
+    /*!
+     * \brief runs a deferred loader, if any, to create the children
+     */
+    void _materialize() const
     {
-        if(path.empty()) {
-            throw std::invalid_argument("Path is empty");
-        } else if (path[0] == '.' || path[path.size()-1] == '.') {
-            throw std::invalid_argument("Path can not begin or end with dot(.)");
+        if (!m_children) {
+            return;
+        }
+        if (m_children->source) {
+            m_children->fill();
+        }
+        if (!m_children->deferred) {
+            return;
         }
+#ifdef LIBCONFIGPP_HAS_THREADS
+        std::lock_guard<std::recursive_mutex> lock(m_children->mutex);
+#endif
+        // the loader adds to this setting, which materializes it again
+        if (!m_children->deferred || m_children->loading) {
+            return;
+        }
+        m_children->loading = true;
+        try {
+            m_children->loader(const_cast<basic_setting&>(*this));
+        } catch (...) {
+            m_children->clear();
+            m_children->loading = false;
+            throw;
+        }
+        m_children->loaded();
     }
 
-    static void _check_index(int index)
+    void _copy_children(const basic_setting& other)
     {
-        if(index < 0) {
-            throw std::invalid_argument("Index can not be negative number");
+        if (!other.m_children) {
+            return;
         }
+        m_children.reset(_new_children(m_atoms, m_type == TypeGroup));
+        m_children->owner = this;
+        m_children->link(other.m_children.get());
     }
 
-    static SettingNameException _name_ex(const string_type& msg, const string_type& path = string_type())
+    /*!
+     * \brief lets pending copies of this setting and of its ancestors copy
+     * their children before this setting changes
+     *
+     * Returns right away while no copies of the tree are pending, so
+     * building a tree does not walk up to the root for every insertion.
+     */
+    void _unshare()
     {
-        return SettingNameException(msg, path);
+        bool pending = m_atoms->copies()->pending != 0;
+        if (m_parent && (pending || m_parent->m_atoms != m_atoms)) {
+            m_parent->_unshare();
+        }
+        if (pending && m_children) {
+            m_children->detach_copies();
+        }
     }
-    static SettingNameException _name_ex(const SettingNameException& ex, const string_type& path = string_type())
+
+    /*!
+     * \brief fills the empty children of this setting with dense copies
+     * of the children in from
+     */
+    void _compact(_children& from)
     {
-        return SettingNameException(ex.what(), path);
+        _children& to = *m_children;
+        if (from.loader) {
+            to.set_loader(from.loader);
+            return;
+        } else if (to.share_source(&from)) {
+            return;
+        }
+        to.items.reserve(from.items.size());
+        for (size_t i = 0; i < from.items.size(); i++) {
+            const basic_setting& child = *from.items[i];
+            value_ptr v(_make_node(string_type(), child.m_type));
+            v->m_name = child.m_name;
+            v->m_format = child.m_format;
+            v->m_file = child.m_file;
+            v->m_line = child.m_line;
+            v->m_scalar = child.m_scalar;
+            v->m_parent = this;
+            v->m_position = i;
+            to.items.push_back(v);
+            if (v->m_children) {
+                v->m_children->owner = v.get();
+                v->_compact(*child.m_children);
+            }
+        }
+        to.reindex();
+        to.packed = from.packed;
     }
-    static SettingTypeException _type_ex(const string_type& msg,const string_type& path = string_type())
+
+    /*!
+     * \brief stores the value of an array element in the packed array of
+     * its parent, so that readers of the array never write to it
+     */
+    void _write_back()
     {
-        return SettingTypeException(msg, path);
+        if (m_parent && m_parent->m_type == TypeArray &&
+                m_parent->m_children->packed.element == m_type &&
+                m_position < m_parent->m_children->packed.size()) {
+            m_parent->m_children->packed.store(m_position, m_scalar, m_format);
+        }
     }
-    static SettingTypeException _type_ex(const SettingTypeException& ex,const string_type& path = string_type())
+
+    void _rebind()
     {
-        return SettingTypeException(ex.what(), path);
+        if (!m_children) {
+            return;
+        }
+        m_children->owner = this;
+        for(size_t i=0; i<m_children->items.size(); i++) {
+            m_children->items[i]->m_parent = this;
+        }
+        typename element_map::const_iterator it;
+        for(it = m_children->elements.begin(); it != m_children->elements.end(); ++it) {
+            it->second->m_parent = this;
+        }
     }
-    static SettingNotFoundException _not_found_ex(const string_type& path = string_type())
+
+    bool _equal_value(const basic_setting& other) const
     {
-        return SettingNotFoundException("Setting not found", path);
+        switch(m_type) {
+        case TypeGroup:
+        {
+            _materialize();
+            other._materialize();
+            const value_array& lhs = m_children->items;
+            if(lhs.size() != other.m_children->items.size()) {
+                return false;
+            }
+            // members are matched by name, independent of their order
+            for(size_t i=0; i<lhs.size(); i++) {
+                const basic_setting* r = other._find(lhs[i]->getName());
+                if(!r || !(*lhs[i] == *r)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case TypeArray:
+            _materialize();
+            other._materialize();
+            return m_children->packed == other.m_children->packed;
+        case TypeList:
+        {
+            _materialize();
+            other._materialize();
+            const value_array& lhs = m_children->items;
+            const value_array& rhs = other.m_children->items;
+            if(lhs.size() != rhs.size()) {
+                return false;
+            }
+            for(size_t i=0; i<lhs.size(); i++) {
+                if (!(*lhs[i] == *rhs[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        default:
+            return m_scalar == other.m_scalar;
+        }
     }
-    static SettingNotFoundException _not_found_ex(size_t index)
+
+    /*!
+     * \brief finds a child by position
+     * \return child or 0 if there is none
+     */
+    basic_setting* _find(size_t index) const
     {
-        std::ostringstream ss;
-        ss << "[" << index << "]";
-        return _not_found_ex(ss.str());
+        switch(m_type) {
+        case TypeGroup:
+        case TypeList:
+            _materialize();
+            if(index < m_children->items.size()) {
+                return m_children->items[index].get();
+            }
+            return 0;
+        case TypeArray:
+            _materialize();
+            if(index < m_children->packed.size()) {
+                return _element(index);
+            }
+            return 0;
+        default:
+            return 0;
+        }
     }
-    static SettingNotFoundException _not_found_ex(const SettingNotFoundException& ex, const string_type& path = string_type())
+
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+    /*!
+     * \brief allocator of shared_ptr control blocks, taken from the
+     * resource of the names table
+     */
+    template<typename T>
+    struct _node_allocator
     {
-        return SettingNotFoundException(ex.what(), path);
-    }
+        typedef T value_type;
 
-    string_type m_name;
-    Type m_type;
-    basic_setting* m_parent;
-    boost::scoped_ptr<_basic_setting> m_value;
-};
+        template<typename U>
+        struct rebind
+        {
+            typedef _node_allocator<U> other;
+        };
 
-template<typename charT>
-class basic_config : public basic_setting<charT>
-{
-public:
-    typedef charT char_type;
-    typedef std::basic_string<charT> string_type;
-    typedef std::vector<string_type> string_array;
-    typedef basic_setting<char_type> value_type;
-    typedef std::vector<value_type> value_array;
-    typedef typename value_array::const_iterator value_iterator;
-    typedef typename value_type::Type config_type;
+        explicit _node_allocator(atom_table* atoms)
+            : atoms(atoms)
+        {}
 
-    basic_config()
-        : value_type(""),
-          m_include_dir(boost::filesystem::current_path().generic_string())
-    {}
+        template<typename U>
+        _node_allocator(const _node_allocator<U>& other)
+            : atoms(other.atoms)
+        {}
 
-    explicit basic_config(const char *path)
-        : value_type(_read_file(path)),
-          m_include_dir(boost::filesystem::current_path().generic_string())
+        T* allocate(size_t n)
+        {
+            return static_cast<T*>(atoms->allocate(n * sizeof(T), boost::alignment_of<T>::value));
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            atoms->deallocate(p, n * sizeof(T), boost::alignment_of<T>::value);
+        }
+
+        template<typename U>
+        bool operator==(const _node_allocator<U>& other) const
+        {
+            return atoms == other.atoms;
+        }
+
+        template<typename U>
+        bool operator!=(const _node_allocator<U>& other) const
+        {
+            return atoms != other.atoms;
+        }
+
+        atom_table* atoms;
+    };
+
+    struct _node_deleter
     {
-    }
+        explicit _node_deleter(atom_table* atoms)
+            : atoms(atoms)
+        {}
 
-    explicit basic_config(const string_type& path)
-        : value_type(_read_file(path)),
-          m_include_dir(boost::filesystem::current_path().generic_string())
+        void operator()(basic_setting* v) const
+        {
+            v->~basic_setting();
+            atoms->deallocate(v, sizeof(basic_setting), boost::alignment_of<basic_setting>::value);
+        }
+
+        atom_table* atoms;
+    };
+
+    void* _allocate_node() const
     {
+        return m_atoms->allocate(sizeof(basic_setting), boost::alignment_of<basic_setting>::value);
     }
 
-    void readFile(const string_type& path)
+    void _deallocate_node(void* memory) const
     {
-        value_type::operator =(_read_file(path, m_include_dir));
+        m_atoms->deallocate(memory, sizeof(basic_setting), boost::alignment_of<basic_setting>::value);
     }
 
-    void writeFile(const string_type& path)
+    value_ptr _own_node(basic_setting* v) const
     {
-        string_type _path = _construct_path(path, m_include_dir);
-        std::basic_ofstream<char_type> ofs(_path.c_str());
-        if (ofs) {
-            ofs << *this;
-        } else {
-            throw FileIOException("Unable to open file " + _path);
+        return value_ptr(v, _node_deleter(m_atoms), _node_allocator<basic_setting>(m_atoms));
+    }
+#endif
+
+    /*!
+     * \brief creates a children list, in the memory resource of atoms if
+     * it has one
+     */
+    static _children* _new_children(atom_table* atoms, bool keyed)
+    {
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+        if (atoms->resource()) {
+            void* memory = atoms->allocate(sizeof(_children), boost::alignment_of<_children>::value);
+            try {
+                return new (memory) _children(atoms, keyed);
+            } catch (...) {
+                atoms->deallocate(memory, sizeof(_children), boost::alignment_of<_children>::value);
+                throw;
+            }
         }
+#endif
+        return new _children(atoms, keyed);
     }
 
-    void setIncludeDir(const string_type& dir)
+    struct _children_deleter
     {
-        m_include_dir = dir;
+        void operator()(_children* children) const
+        {
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+            atom_table* atoms = children->atoms;
+            if (atoms->resource()) {
+                children->~_children();
+                atoms->deallocate(children, sizeof(_children), boost::alignment_of<_children>::value);
+                return;
+            }
+#endif
+            delete children;
+        }
+    };
+
+    typedef boost::movelib::unique_ptr<_children, _children_deleter> children_ptr;
+
+    /*!
+     * \brief creates a copy of other for this tree, in the memory resource
+     * of the tree if it has one
+     */
+    value_ptr _make_node(const basic_setting& other) const
+    {
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+        if (m_atoms->resource()) {
+            void* memory = _allocate_node();
+            basic_setting* v;
+            try {
+                v = new (memory) basic_setting(other, m_atoms);
+            } catch (...) {
+                _deallocate_node(memory);
+                throw;
+            }
+            return _own_node(v);
+        }
+#endif
+        return value_ptr(new basic_setting(other, m_atoms));
     }
 
-    string_type getIncludeDir() const
+    value_ptr _make_node(const string_type& name, Type type) const
     {
-        return m_include_dir;
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+        if (m_atoms->resource()) {
+            void* memory = _allocate_node();
+            basic_setting* v;
+            try {
+                v = new (memory) basic_setting(m_atoms, name, type);
+            } catch (...) {
+                _deallocate_node(memory);
+                throw;
+            }
+            return _own_node(v);
+        }
+#endif
+        return value_ptr(new basic_setting(m_atoms, name, type));
     }
 
-    const basic_setting<char_type>& getRoot() const
+    /*!
+     * \brief returns the setting of an array element, creating it on first access
+     */
+    basic_setting* _element(size_t index) const
     {
-        return *this;
+#ifdef LIBCONFIGPP_HAS_THREADS
+        std::lock_guard<std::recursive_mutex> lock(m_children->mutex);
+#endif
+        typename element_map::const_iterator it = m_children->elements.find(index);
+        if (it != m_children->elements.end()) {
+            return it->second.get();
+        }
+        const _packed_array& packed = m_children->packed;
+        value_ptr v(_make_node(string_type(), packed.element));
+        packed.load(index, v->m_scalar);
+        v->m_format = packed.format(index);
+        v->m_file = m_file;
+        v->m_line = m_line;
+        v->m_parent = const_cast<basic_setting*>(this);
+        v->m_position = index;
+        m_children->elements.insert(std::make_pair(index, v));
+        return v.get();
     }
 
-    basic_setting<char_type>& getRoot()
+    /*!
+     * \brief finds a child of a group by name
+     * \return child or 0 if there is none
+     */
+    basic_setting* _find(const string_type& name) const
     {
-        return *this;
+        if (m_type != TypeGroup) {
+            return 0;
+        }
+        _materialize();
+        atom_type atom = m_atoms->find(name);
+        if (atom == atom_table::npos) {
+            return 0;
+        }
+        size_t position = m_children->find(atom);
+        if (position < m_children->items.size()) {
+            return m_children->items[position].get();
+        }
+        return 0;
     }
 
+    basic_setting& _child(size_t index) const
+    {
+        basic_setting* child = _find(index);
+        if (!child) {
+            throw _not_found_ex(index);
+        }
+        return *child;
+    }
 
-private:
-    class token;
-    typedef std::vector<token> token_array;
-    typedef typename token_array::const_iterator token_iterator;
-    typedef boost::shared_ptr<string_type> string_ptr;
+    basic_setting& _child(const string_type& name) const
+    {
+        basic_setting* child = _find(name);
+        if (!child) {
+            throw _not_found_ex(name);
+        }
+        return *child;
+    }
 
-    string_type m_include_dir;
+    size_t _size() const
+    {
+        switch(m_type) {
+        case TypeGroup:
+        case TypeList:
+            _materialize();
+            return m_children->items.size();
+        case TypeArray:
+            _materialize();
+            return m_children->packed.size();
+        default:
+            return 0;
+        }
+    }
 
-    class _basic_setting : public value_type
+    basic_setting& _add(const basic_setting& value)
     {
-    public:
-        _basic_setting(typename value_type::Type type)
-            : value_type("", type)
-        {}
-        _basic_setting(const string_type& name, typename value_type::Type type = value_type::TypeGroup)
-            : value_type(name, type)
-        {}
-        _basic_setting(const _basic_setting& other)
-            : value_type(other)
-        {}
-        _basic_setting& operator=(const _basic_setting& other)
+        _unshare();
+        switch(m_type) {
+        case TypeGroup:
         {
-            if (this != &other) {
-                value_type::operator =(other);
+            _materialize();
+            atom_type atom = value.m_atoms == m_atoms ? value.m_name
+                                                      : m_atoms->intern(value.getName());
+            if (m_children->find(atom) < m_children->items.size()) {
+                throw _name_ex(value.getName() + " already exists");
             }
-            return *this;
+            value_ptr v(_make_node(value));
+            _adopt(v);
+            return *v;
         }
-
-        template<typename T>
-        _basic_setting& operator=(const T& value)
+        case TypeArray:
+            _append(value);
+            return *_element(m_children->packed.size() - 1);
+        case TypeList:
         {
-            value_type::operator =(value);
-            return *this;
+            _materialize();
+            value_ptr v(_make_node(value));
+            _adopt(v);
+            return *v;
         }
+        default:
+            throw ConfigException("operation not supported");
+        }
+    }
 
-        value_type& add(const _basic_setting &setting)
+    /*!
+     * \brief creates an empty child in place, without copying a temporary
+     */
+    basic_setting& _emplace(const string_type& name, Type type)
+    {
+        _unshare();
+        switch(m_type) {
+        case TypeGroup:
+        case TypeList:
         {
-            return value_type::add(setting);
+            _materialize();
+            value_ptr v(_make_node(name, type));
+            _adopt(v);
+            return *v;
         }
-    };
+        default:
+            return _add(basic_setting(m_atoms, name, type));
+        }
+    }
 
-    typedef std::vector<_basic_setting> _basic_setting_array;
+    /*!
+     * \brief makes a setting using the atoms of this group or list its last child
+     */
+    void _adopt(const value_ptr& v)
+    {
+        BOOST_ASSERT(v->m_atoms == m_atoms);
+        if (m_type == TypeGroup) {
+            if (m_children->find(v->m_name) < m_children->items.size()) {
+                throw _name_ex(v->getName() + " already exists");
+            }
+            v->m_parent = this;
+            m_children->push_back(v);
+        } else {
+            v->m_parent = this;
+            v->m_position = m_children->items.size();
+            m_children->items.push_back(v);
+        }
+    }
 
-    class token : public string_type
+    /*!
+     * \brief moves the children of other behind the children of this setting
+     *
+     * Both settings must have the same type and atoms. Children are moved,
+     * not copied; array elements are copied from one packed vector to the
+     * other.
+     */
+    void _splice(basic_setting& other)
     {
-    public:
-        token() : string_type(), line(0), offset(0), file() {}
+        BOOST_ASSERT(other.m_type == m_type);
+        _unshare();
+        other._unshare();
+        _materialize();
+        other._materialize();
+        if (m_type == TypeArray) {
+            const _packed_array& packed = other.m_children->packed;
+            if (packed.size() && m_children->packed.size() &&
+                    packed.element != m_children->packed.element) {
+                throw _type_ex("Array elements must have same type");
+            }
+            _scalar_value value(packed.element);
+            for(size_t i=0; i<packed.size(); i++) {
+                packed.load(i, value);
+                m_children->packed.push_back(value, packed.format(i));
+            }
+        } else {
+            value_array items(other.m_children->items.get_allocator());
+            items.swap(other.m_children->items);
+            for(size_t i=0; i<items.size(); i++) {
+                _adopt(items[i]);
+            }
+        }
+        other.m_children->clear();
+    }
 
-        token(const char_type* arg, size_t _line = 0, size_t _offset = 0)
-            : string_type(arg), line(_line), offset(_offset), file()
-        {}
+    /*!
+     * \brief adds a child without creating a setting for array elements
+     */
+    void _append(const basic_setting& value)
+    {
+        if (m_type != TypeArray) {
+            _add(value);
+            return;
+        }
+        _unshare();
+        _materialize();
+        _packed_array& packed = m_children->packed;
+        if(!value.isScalar()) {
+            throw _type_ex("Array elements must be scalar values");
+        }
+        if (packed.size() && packed.element != value.getType()) {
+            throw _type_ex("Array elements must have same type");
+        }
+        packed.push_back(value.m_scalar, value.m_format);
+    }
 
-        explicit token(char_type arg, size_t _line = 0, size_t _offset = 0)
-            : string_type(), line(_line), offset(_offset), file()
-        {
-            *this += arg;
+    void _remove(const string_type& property)
+    {
+        _unshare();
+        if (m_type == TypeGroup) {
+            _materialize();
+            atom_type atom = m_atoms->find(property);
+            size_t position = atom != atom_table::npos ? m_children->find(atom)
+                                                       : m_children->items.size();
+            if (position < m_children->items.size()) {
+                m_children->erase(position);
+                m_atoms->invalidate();
+                return;
+            }
         }
+        throw _not_found_ex(property);
+    }
 
-        token(const string_type& arg, size_t _line = 0, size_t _offset = 0)
-            : string_type(arg), line(_line), offset(_offset), file()
-        {}
+    void _remove(size_t index)
+    {
+        _unshare();
+        switch(m_type) {
+        case TypeGroup:
+        case TypeList:
+            _materialize();
+            if(index >= m_children->items.size()) {
+                throw _not_found_ex(index);
+            }
+            m_children->erase(index);
+            m_atoms->invalidate();
+            break;
+        case TypeArray:
+            _materialize();
+            if(index >= m_children->packed.size()) {
+                throw _not_found_ex(index);
+            }
+            m_children->erase_element(index);
+            m_atoms->invalidate();
+            break;
+        default:
+            throw _not_found_ex(index);
+        }
+    }
 
-        template<typename T>
-        token& operator=(const T& other)
+    void _print_value(std::ostream& o, size_t level) const
+    {
+        switch(m_type) {
+        case TypeGroup:
         {
-            string_type::operator =(other);
-            return *this;
-        }
+            _materialize();
+            const value_array& items = m_children->items;
+            bool complex = m_parent || m_name;
+            string_type ident_p(level * 4, ' ');
+            size_t level_c = complex ? level + 1 : level;
+            string_type ident_c(level_c * 4, ' ');
 
-        token& operator=(const token& other)
+            if(items.empty()) {
+                o << "{}";
+            } else {
+                if (complex)
+                    o << "{\n";
+
+                for(size_t i=0; i<items.size(); i++)
+                {
+                    o << ident_c;
+                    items[i]->print(o, level_c);
+                    o << ";\n";
+                }
+                if (complex)
+                    o << ident_p << "}";
+            }
+            break;
+        }
+        case TypeList:
         {
-            if (other != *this) {
-                string_type::operator =(other);
-                line = other.line;
-                offset = other.offset;
-                file = other.file;
+            _materialize();
+            const value_array& items = m_children->items;
+            string_type ident_p(level * 4, ' ');
+            string_type ident_c((level+1) * 4, ' ');
+            if(items.empty()) {
+                o << "()";
+            } else {
+                o << "(\n";
+                for(size_t i=0; i<items.size(); i++) {
+                    if (i > 0)
+                        o << ident_c << ",\n";
+                    o << ident_c;
+                    items[i]->print(o, level+1);
+                    o << "\n";
+                }
+                o << ident_p << ")";
             }
-            return *this;
+            break;
         }
+        case TypeArray:
+        {
+            _materialize();
+            const _packed_array& packed = m_children->packed;
+            _scalar_value value(packed.element);
+            o << "[";
+            for(size_t i = 0; i < packed.size(); i++) {
+                if (i>0)
+                    o  << ", ";
+                packed.load(i, value);
+                _print_scalar(o, value, packed.format(i));
+            }
+            o << "]";
+            break;
+        }
+        default:
+            _print_scalar(o, m_scalar, m_format);
+        }
+    }
 
-        size_t line;
-        size_t offset;
-        string_ptr file;
-    };
-
-    class config_tokenizer
+    static void _print_scalar(std::ostream& o, const _scalar_value& value, Format format)
     {
-    public:
-        typedef char_type Char;
+        if ((value.type() == TypeInt || value.type() == TypeInt64) && format == FormatHex) {
+            o << "0x" << std::hex;
+        }
 
-        config_tokenizer() : separators("{}[](),/\\\"=:;")
+        switch(value.type())
         {
-            reset();
+        case TypeBoolean:
+            o << value.boolean();
+            break;
+        case TypeInt:
+            o << value.integer();
+            break;
+        case TypeInt64:
+            o << value.integer64() << "L";
+            break;
+        case TypeFloat:
+            o << value.floating();
+            break;
+        default:
+            o << '"' << value.string() << '"';
         }
 
-        template<typename InputIterator, typename Token>
-        bool operator()(InputIterator& next, InputIterator& end, Token &tok)
+        o << std::dec;
+    }
+
+    void _lookup(bool& result) const
+    {
+        switch(m_type) {
+        case TypeBoolean:
+        case TypeInt:
+        case TypeInt64:
         {
-            if(!tmp_token.empty()) {
-                tok = tmp_token;
-                tok.line = line;
-                tok.offset = offset;
-                tmp_token.resize(0);
-                return true;
-            }
+            long t;
+            _lookup(t);
+            result = t != 0;
+            break;
+        }
+        case TypeFloat:
+            result = m_scalar.floating() != 0;
+            break;
+        default:
+            throw _type_ex("unsupported conversion");
+        }
+    }
 
-            bool escape = false;
-            bool is_identifier = false;
+    void _assign(bool value)
+    {
+        _unshare();
+        switch(m_type) {
+        case TypeBoolean:
+            m_scalar.boolean() = value;
+            break;
+        case TypeInt:
+            m_scalar.integer() = value ? 1 : 0;
+            break;
+        case TypeInt64:
+            m_scalar.integer64() = value ? 1L : 0L;
+            break;
+        default:
+            throw _type_ex("Conversion not possible");
+        }
+        _write_back();
+    }
+
+    void _lookup(int& result) const
+    {
+        long t;
+        _lookup(t);
+        if(t > std::numeric_limits<int>::max() || t < std::numeric_limits<int>::min()) {
+            throw _type_ex("type overflow");
+        }
+        result = t;
+    }
+
+    void _lookup(unsigned int& result) const
+    {
+        long t;
+        _lookup(t);
+        if(t < 0) {
+            throw _type_ex("negative value");
+        } else if (static_cast<unsigned long>(t) > std::numeric_limits<unsigned int>::max()) {
+            throw _type_ex("type overflow");
+        }
+        result = t;
+    }
+
+    void _lookup(long& result) const
+    {
+        switch(m_type) {
+        case TypeBoolean:
+            result = m_scalar.boolean() ? 1 : 0;
+            break;
+        case TypeInt:
+            result = m_scalar.integer();
+            break;
+        case TypeInt64:
+            result = m_scalar.integer64();
+            break;
+        default:
+            throw _type_ex("unsupported conversion");
+        }
+    }
+
+    void _assign(long value)
+    {
+        _unshare();
+        switch(m_type) {
+        case TypeBoolean:
+            m_scalar.boolean() = static_cast<bool>(value);
+            break;
+        case TypeInt:
+            m_scalar.integer() = static_cast<int>(value);
+            break;
+        case TypeInt64:
+            m_scalar.integer64() = value;
+            break;
+        case TypeFloat:
+            m_scalar.floating() = static_cast<float>(value);
+            break;
+        default:
+            throw _type_ex("Conversion not possible");
+        }
+        _write_back();
+    }
+
+    void _lookup(unsigned long& result) const
+    {
+        long t;
+        _lookup(t);
+        if (t < 0) {
+            throw _type_ex("negative value");
+        }
+        result = t;
+    }
+
+    void _lookup(float& result) const
+    {
+        if (m_type == TypeFloat) {
+            result = m_scalar.floating();
+        } else {
+            long t;
+            _lookup(t);
+            result = t;
+        }
+    }
+
+    void _assign(float value)
+    {
+        _unshare();
+        switch(m_type) {
+        case TypeInt:
+            m_scalar.integer() = static_cast<int>(value);
+            break;
+        case TypeInt64:
+            m_scalar.integer64() = static_cast<long>(value);
+            break;
+        case TypeFloat:
+            m_scalar.floating() = value;
+            break;
+        default:
+            throw _type_ex("Conversion not possible");
+        }
+        _write_back();
+    }
+
+    void _lookup(double& result) const
+    {
+        float t;
+        _lookup(t);
+        result = t;
+    }
+
+    void _lookup(string_type& result) const
+    {
+        result = _string();
+    }
+
+    const string_type& _string() const
+    {
+        if (m_type != TypeString) {
+            throw _type_ex("unsupported conversion");
+        }
+        return m_scalar.string();
+    }
+
+    void _assign(const string_type& value)
+    {
+        if (m_type != TypeString) {
+            throw _type_ex("Conversion not possible");
+        }
+        _unshare();
+        m_scalar.string() = value;
+        _write_back();
+    }
+
+    basic_setting& _array_at(const string_type& path)
+    {
+        _check_path(path);
+        if (_exists(path)) {
+            basic_setting& array = _at(path);
+            if (array.m_type != TypeArray) {
+                throw _type_ex("setting is not an array", path);
+            }
+            return array;
+        }
+        basic_setting& parent = _at(_parent(path));
+        if (parent.m_type != TypeGroup) {
+            throw _type_ex("parent of the array is not a group", path);
+        }
+        return parent._emplace(_leaf(path), TypeArray);
+    }
+
+    template<typename Iterator>
+    void _set_array(Iterator first, Iterator last)
+    {
+        _unshare();
+        _materialize();
+        typedef typename std::iterator_traits<Iterator>::value_type value_type;
+        // any other pointer would be taken for a bool
+        BOOST_STATIC_ASSERT(!boost::is_pointer<value_type>::value ||
+                            boost::is_same<typename boost::remove_cv<
+                                typename boost::remove_pointer<value_type>::type>::type,
+                                char_type>::value);
+        m_children->packed.assign(_type_of(value_type()), first, last);
+        if (!m_children->elements.empty()) {
+            m_children->elements.clear();
+            m_atoms->invalidate();
+        }
+    }
+
+    template<typename A>
+    static void _convert_array(const std::vector<bool, A>& from, std::vector<bool>& to)
+    {
+        to.assign(from.begin(), from.end());
+    }
+
+    template<typename A>
+    static void _convert_array(const std::vector<int, A>& from, std::vector<int>& to)
+    {
+        to.assign(from.begin(), from.end());
+    }
+
+    template<typename A>
+    static void _convert_array(const std::vector<long, A>& from, std::vector<long>& to)
+    {
+        to.assign(from.begin(), from.end());
+    }
+
+    template<typename A>
+    static void _convert_array(const std::vector<float, A>& from, std::vector<float>& to)
+    {
+        to.assign(from.begin(), from.end());
+    }
+
+    template<typename A>
+    static void _convert_array(const std::vector<string_type, A>& from, std::vector<string_type>& to)
+    {
+        to.assign(from.begin(), from.end());
+    }
+
+    template<typename A, typename T>
+    static void _convert_array(const std::vector<string_type, A>&, std::vector<T>&)
+    {
+        throw _type_ex("unsupported conversion");
+    }
+
+    template<typename S, typename A>
+    static void _convert_array(const std::vector<S, A>&, std::vector<string_type>&)
+    {
+        throw _type_ex("unsupported conversion");
+    }
+
+    template<typename S, typename A, typename T>
+    static void _convert_array(const std::vector<S, A>& from, std::vector<T>& to)
+    {
+        to.resize(from.size());
+        for (size_t i = 0; i < from.size(); i++) {
+            // a local, since the elements of std::vector<bool> are proxies
+            T value;
+            _convert_number(_widen(from[i]), value);
+            to[i] = value;
+        }
+    }
+
+    static long _widen(bool value)
+    {
+        return value ? 1 : 0;
+    }
+
+    static long _widen(int value)
+    {
+        return value;
+    }
+
+    static long _widen(long value)
+    {
+        return value;
+    }
+
+    static float _widen(float value)
+    {
+        return value;
+    }
+
+    static void _convert_number(long value, bool& result)
+    {
+        result = value != 0;
+    }
+
+    static void _convert_number(long value, int& result)
+    {
+        if(value > std::numeric_limits<int>::max() || value < std::numeric_limits<int>::min()) {
+            throw _type_ex("type overflow");
+        }
+        result = value;
+    }
+
+    static void _convert_number(long value, unsigned& result)
+    {
+        if(value < 0) {
+            throw _type_ex("negative value");
+        } else if (static_cast<unsigned long>(value) > std::numeric_limits<unsigned int>::max()) {
+            throw _type_ex("type overflow");
+        }
+        result = value;
+    }
+
+    static void _convert_number(long value, long& result)
+    {
+        result = value;
+    }
+
+    static void _convert_number(long value, unsigned long& result)
+    {
+        if (value < 0) {
+            throw _type_ex("negative value");
+        }
+        result = value;
+    }
+
+    static void _convert_number(long value, float& result)
+    {
+        result = value;
+    }
+
+    static void _convert_number(long value, double& result)
+    {
+        result = static_cast<float>(value);
+    }
+
+    static void _convert_number(float value, bool& result)
+    {
+        result = value != 0;
+    }
+
+    static void _convert_number(float value, float& result)
+    {
+        result = value;
+    }
+
+    static void _convert_number(float value, double& result)
+    {
+        result = value;
+    }
+
+    template<typename T>
+    static void _convert_number(float, T&)
+    {
+        throw _type_ex("unsupported conversion");
+    }
+
+    template<typename T>
+    basic_setting& _emplace_value(const string_type& name, const T& value)
+    {
+        if (m_type == TypeArray) {
+            _append_value(value);
+            return *_element(m_children->packed.size() - 1);
+        }
+        basic_setting& child = _emplace(name, _type_of(value));
+        _store(child.m_scalar, value);
+        return child;
+    }
+
+    template<typename T>
+    void _append_value(const T& value)
+    {
+        if (m_type != TypeArray) {
+            _emplace_value(string_type(), value);
+            return;
+        }
+        _unshare();
+        _materialize();
+        _packed_array& packed = m_children->packed;
+        if (packed.size() && packed.element != _type_of(value)) {
+            throw _type_ex("Array elements must have same type");
+        }
+        packed.push_back(_type_of(value), value);
+    }
+
+    static Type _type_of(bool)
+    {
+        return TypeBoolean;
+    }
+
+    static Type _type_of(int)
+    {
+        return TypeInt;
+    }
+
+    static Type _type_of(long)
+    {
+        return TypeInt64;
+    }
+
+    static Type _type_of(float)
+    {
+        return TypeFloat;
+    }
+
+    static Type _type_of(double)
+    {
+        return TypeFloat;
+    }
+
+    static Type _type_of(const string_type&)
+    {
+        return TypeString;
+    }
+
+    static Type _type_of(const char_type*)
+    {
+        return TypeString;
+    }
+
+    static void _store(_scalar_value& scalar, bool value)
+    {
+        scalar.boolean() = value;
+    }
+
+    static void _store(_scalar_value& scalar, int value)
+    {
+        scalar.integer() = value;
+    }
+
+    static void _store(_scalar_value& scalar, long value)
+    {
+        scalar.integer64() = value;
+    }
+
+    static void _store(_scalar_value& scalar, float value)
+    {
+        scalar.floating() = value;
+    }
+
+    static void _store(_scalar_value& scalar, const string_type& value)
+    {
+        scalar.string() = value;
+    }
+
+    static void _check_path(const string_type& path)
+    {
+        if(path.empty()) {
+            throw std::invalid_argument("Path is empty");
+        } else if (path[0] == '.' || path[path.size()-1] == '.') {
+            throw std::invalid_argument("Path can not begin or end with dot(.)");
+        }
+    }
+
+    static void _check_index(int index)
+    {
+        if(index < 0) {
+            throw std::invalid_argument("Index can not be negative number");
+        }
+    }
+
+    static SettingNameException _name_ex(const string_type& msg, const string_type& path = string_type())
+    {
+        return SettingNameException(msg, path);
+    }
+    static SettingNameException _name_ex(const SettingNameException& ex, const string_type& path = string_type())
+    {
+        return SettingNameException(ex.what(), path);
+    }
+    static SettingTypeException _type_ex(const string_type& msg,const string_type& path = string_type())
+    {
+        return SettingTypeException(msg, path);
+    }
+    static SettingTypeException _type_ex(const SettingTypeException& ex,const string_type& path = string_type())
+    {
+        return SettingTypeException(ex.what(), path);
+    }
+    static SettingNotFoundException _not_found_ex(const string_type& path = string_type())
+    {
+        return SettingNotFoundException("Setting not found", path);
+    }
+    static SettingNotFoundException _not_found_ex(size_t index)
+    {
+        std::ostringstream ss;
+        ss << "[" << index << "]";
+        return _not_found_ex(ss.str());
+    }
+    static SettingNotFoundException _not_found_ex(const SettingNotFoundException& ex, const string_type& path = string_type())
+    {
+        return SettingNotFoundException(ex.what(), path);
+    }
+
+    atom_table* m_atoms;
+    atom_type m_name;
+    Type m_type;
+    Format m_format;
+    atom_type m_file;           //!< source file, interned like the names
+    unsigned m_line;            //!< source line, 0 if the setting was not read
+    basic_setting* m_parent;
+    size_t m_position;          //!< index in the parent, kept up to date by add and remove
+    _scalar_value m_scalar;
+    children_ptr m_children;
+};
+
+/*!
+ * \brief non-owning handle of a setting
+ *
+ * A reference is three words, is trivially copyable and is passed by
+ * value. It records the generation of the names table of its tree, so it
+ * notices when settings of the tree were removed or the tree was read
+ * again and then throws instead of touching a destroyed setting. It must
+ * not outlive the config it was taken from.
+ */
+template<typename charT>
+class basic_setting_ref
+{
+public:
+    typedef charT char_type;
+    typedef typename std::basic_string<charT> string_type;
+    typedef basic_setting<charT> setting_type;
+    typedef typename setting_type::Type Type;
+    typedef typename setting_type::Format Format;
+
+    /*!
+     * \brief iterates over the children of a reference in order
+     */
+    class iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef basic_setting_ref value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const basic_setting_ref* pointer;
+        typedef basic_setting_ref reference;
+
+        iterator()
+            : m_index(0)
+        {}
+
+        iterator(const basic_setting_ref& parent, size_t index)
+            : m_parent(parent),
+              m_index(index)
+        {}
+
+        basic_setting_ref operator*() const
+        {
+            return m_parent[static_cast<int>(m_index)];
+        }
+
+        iterator& operator++()
+        {
+            m_index++;
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator result(*this);
+            m_index++;
+            return result;
+        }
+
+        bool operator==(const iterator& other) const
+        {
+            return m_index == other.m_index && m_parent.m_setting == other.m_parent.m_setting;
+        }
+
+        bool operator!=(const iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        basic_setting_ref m_parent;
+        size_t m_index;
+    };
+
+    typedef iterator const_iterator;
+
+    basic_setting_ref()
+        : m_setting(0),
+          m_atoms(0),
+          m_generation(0)
+    {}
+
+    basic_setting_ref(const setting_type& setting)
+        : m_setting(&setting),
+          m_atoms(setting.m_atoms),
+          m_generation(setting.m_atoms->generation())
+    {}
+
+    /*!
+     * \brief returns false if the reference is empty or settings of its
+     * tree were destroyed since it was taken
+     */
+    bool isValid() const
+    {
+        return m_setting && m_atoms->generation() == m_generation;
+    }
+
+    /*!
+     * \brief returns the setting, throws if the reference is not valid
+     */
+    const setting_type& get() const
+    {
+        if (!isValid()) {
+            throw SettingNotFoundException("Setting reference is stale", string_type());
+        }
+        return *m_setting;
+    }
+
+    basic_setting_ref operator[](const char* path) const
+    {
+        return get()[path];
+    }
+
+    basic_setting_ref operator[](const string_type& path) const
+    {
+        return get()[path];
+    }
+
+    basic_setting_ref operator[](int index) const
+    {
+        return get()[index];
+    }
+
+    iterator begin() const
+    {
+        return iterator(*this, 0);
+    }
+
+    iterator end() const
+    {
+        return iterator(*this, getLength());
+    }
+
+    template<typename T>
+    bool lookupValue(const string_type& path, T& value) const
+    {
+        return get().lookupValue(path, value);
+    }
+
+    bool exists(const string_type& path) const
+    {
+        return get().exists(path);
+    }
+
+    string_type getName() const
+    {
+        return get().getName();
+    }
+
+    string_type getPath() const
+    {
+        return get().getPath();
+    }
+
+    basic_setting_ref getParent() const
+    {
+        return get().getParent();
+    }
+
+    int getIndex() const
+    {
+        return get().getIndex();
+    }
+
+    Type getType() const
+    {
+        return get().getType();
+    }
+
+    Format getFormat() const
+    {
+        return get().getFormat();
+    }
+
+    size_t getLength() const
+    {
+        return get().getLength();
+    }
+
+    bool isGroup() const
+    {
+        return get().isGroup();
+    }
+
+    bool isArray() const
+    {
+        return get().isArray();
+    }
+
+    bool isList() const
+    {
+        return get().isList();
+    }
+
+    bool isAggredate() const
+    {
+        return get().isAggredate();
+    }
+
+    bool isScalar() const
+    {
+        return get().isScalar();
+    }
+
+    bool isNumber() const
+    {
+        return get().isNumber();
+    }
+
+    bool isRoot() const
+    {
+        return get().isRoot();
+    }
+
+    operator bool () const
+    {
+        return static_cast<bool>(get());
+    }
+
+    operator int () const
+    {
+        return static_cast<int>(get());
+    }
+
+    operator unsigned () const
+    {
+        return static_cast<unsigned>(get());
+    }
+
+    operator long () const
+    {
+        return static_cast<long>(get());
+    }
+
+    operator unsigned long () const
+    {
+        return static_cast<unsigned long>(get());
+    }
+
+    operator float () const
+    {
+        return static_cast<float>(get());
+    }
+
+    operator double () const
+    {
+        return static_cast<double>(get());
+    }
+
+    operator string_type () const
+    {
+        return static_cast<string_type>(get());
+    }
+
+    const string_type& getString() const
+    {
+        return get().getString();
+    }
+
+    template<typename T>
+    void getArray(std::vector<T>& values) const
+    {
+        get().getArray(values);
+    }
+
+    template<typename T>
+    void getArray(const string_type& path, std::vector<T>& values) const
+    {
+        get().getArray(path, values);
+    }
+
+    const char_type* c_str() const
+    {
+        return get().c_str();
+    }
+
+private:
+    const setting_type* m_setting;
+    const basic_atom_table<charT>* m_atoms;
+    unsigned long m_generation;
+};
+
+template<typename charT>
+class basic_config : private boost::base_from_member<boost::shared_ptr<basic_atom_table<charT> > >,
+                     public basic_setting<charT>
+{
+    typedef boost::base_from_member<boost::shared_ptr<basic_atom_table<charT> > > atom_holder;
+
+public:
+    typedef charT char_type;
+    typedef std::basic_string<charT> string_type;
+    typedef std::vector<string_type> string_array;
+    typedef basic_setting<char_type> value_type;
+    typedef std::vector<value_type> value_array;
+    typedef typename value_array::const_iterator value_iterator;
+    typedef typename value_type::Type config_type;
+    typedef typename value_type::atom_table atom_table;
+    typedef boost::shared_ptr<basic_config> config_ptr;
+
+    enum Option {
+        OptionNone = 0x00,
+        OptionLazyParse = 0x01,
+        OptionParallelParse = 0x02,
+        OptionLazyScalars = 0x04
+    };
+
+    basic_config()
+        : atom_holder(new atom_table()),
+          value_type(atom_holder::member.get(), ""),
+          m_include_dir(boost::filesystem::current_path().generic_string()),
+          m_options(OptionNone),
+          m_parse_threads(0)
+    {}
+
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+    /*!
+     * \brief creates an empty config whose settings are allocated from resource
+     *
+     * This config and its copies allocate the settings, their reference
+     * counts and their children lists, including the packed elements of
+     * arrays, from resource. Names and string values still use the global
+     * heap, as they are std::basic_string.
+     * resource must outlive the config and its copies.
+     */
+    explicit basic_config(std::pmr::memory_resource* resource)
+        : atom_holder(new atom_table(resource)),
+          value_type(atom_holder::member.get(), ""),
+          m_include_dir(boost::filesystem::current_path().generic_string()),
+          m_options(OptionNone),
+          m_parse_threads(0)
+    {}
+
+    std::pmr::memory_resource* getMemoryResource() const
+    {
+        return atom_holder::member->resource();
+    }
+#endif
+
+    explicit basic_config(const char *path)
+        : atom_holder(new atom_table()),
+          value_type(atom_holder::member.get(), ""),
+          m_include_dir(boost::filesystem::current_path().generic_string()),
+          m_options(OptionNone),
+          m_parse_threads(0)
+    {
+        readFile(path);
+    }
+
+    explicit basic_config(const string_type& path)
+        : atom_holder(new atom_table()),
+          value_type(atom_holder::member.get(), ""),
+          m_include_dir(boost::filesystem::current_path().generic_string()),
+          m_options(OptionNone),
+          m_parse_threads(0)
+    {
+        readFile(path);
+    }
+
+    /*!
+     * \brief copies the tree of other, the copy shares the names of other
+     */
+    basic_config(const basic_config& other)
+        : atom_holder(other.atom_holder::member),
+          value_type(other),
+          m_include_dir(other.m_include_dir),
+          m_options(other.m_options),
+          m_parse_threads(other.m_parse_threads)
+    {}
+
+    basic_config& operator=(const basic_config& other)
+    {
+        if (this != &other) {
+            basic_config copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    /*!
+     * \brief takes the tree of other without cloning, other is left empty
+     */
+    basic_config(basic_config&& other)
+        : atom_holder(other.atom_holder::member),
+          value_type(static_cast<value_type&&>(other)),
+          m_include_dir(static_cast<string_type&&>(other.m_include_dir)),
+          m_options(other.m_options),
+          m_parse_threads(other.m_parse_threads)
+    {}
+
+    basic_config& operator=(basic_config&& other)
+    {
+        if (this != &other) {
+            basic_config moved(static_cast<basic_config&&>(other));
+            swap(moved);
+        }
+        return *this;
+    }
+#endif
+
+    /*!
+     * \brief exchanges tree, names and settings with other without cloning
+     */
+    void swap(basic_config& other)
+    {
+        atom_holder::member.swap(other.atom_holder::member);
+        value_type::swap(other);
+        m_include_dir.swap(other.m_include_dir);
+        std::swap(m_options, other.m_options);
+        std::swap(m_parse_threads, other.m_parse_threads);
+    }
+
+    void readFile(const string_type& path, const ParseLimits& limits = ParseLimits())
+    {
+        _basic_setting root(atom_holder::member.get(), "");
+        parse_budget budget(limits);
+        parser p(string_ptr(new string_type(_construct_path(path, m_include_dir))),
+                 m_include_dir, 0, budget);
+        _read(p, limits, root);
+        value_type::swap(root);
+        atom_holder::member->invalidate();
+    }
+
+    void readString(const string_type& str, const ParseLimits& limits = ParseLimits())
+    {
+        _basic_setting root(atom_holder::member.get(), "");
+        parse_budget budget(limits);
+        parser p(str, m_include_dir, budget);
+        _read(p, limits, root);
+        value_type::swap(root);
+        atom_holder::member->invalidate();
+    }
+
+#ifdef LIBCONFIGPP_HAS_FUTURES
+    /*!
+     * \brief reads a file into a new config on a separate thread
+     *
+     * The new config uses the include directory, options and parse threads
+     * of this config. Errors are rethrown by get() on the returned future.
+     * \param path file to read
+     * \param limits limits applied while reading
+     * \return future holding the new config
+     */
+    std::future<config_ptr> loadAsync(const string_type& path,
+                                      const ParseLimits& limits = ParseLimits()) const
+    {
+        return std::async(std::launch::async, load_request(*this, path, limits));
+    }
+
+    /*!
+     * \brief reads a file into a new config on a caller supplied executor
+     * \param path file to read
+     * \param executor called once with a nullary function that performs the read
+     * \param limits limits applied while reading
+     * \return future holding the new config
+     */
+    template<typename Executor>
+    std::future<config_ptr> loadAsync(const string_type& path, Executor executor,
+                                      const ParseLimits& limits = ParseLimits()) const
+    {
+        boost::shared_ptr<load_task> task(new load_task(load_request(*this, path, limits)));
+        std::future<config_ptr> result = task->get_future();
+        executor(boost::function<void ()>(load_task_runner(task)));
+        return result;
+    }
+#endif
+
+    void writeFile(const string_type& path)
+    {
+        string_type _path = _construct_path(path, m_include_dir);
+        std::basic_ofstream<char_type> ofs(_path.c_str());
+        if (ofs) {
+            ofs << *this;
+        } else {
+            throw FileIOException("Unable to open file " + _path);
+        }
+    }
+
+    void setIncludeDir(const string_type& dir)
+    {
+        m_include_dir = dir;
+    }
+
+    string_type getIncludeDir() const
+    {
+        return m_include_dir;
+    }
+
+    /*!
+     * \brief sets the options used by subsequent reads
+     * \param options bitwise or of Option values
+     */
+    void setOptions(int options)
+    {
+        m_options = options;
+    }
+
+    int getOptions() const
+    {
+        return m_options;
+    }
+
+    void setOption(Option option, bool flag)
+    {
+        if (flag) {
+            m_options |= option;
+        } else {
+            m_options &= ~option;
+        }
+    }
+
+    bool getOption(Option option) const
+    {
+        return (m_options & option) != 0;
+    }
+
+    /*!
+     * \brief sets the number of threads used with OptionParallelParse
+     * \param threads number of threads, 0 selects the hardware concurrency
+     */
+    void setParseThreads(unsigned threads)
+    {
+        m_parse_threads = threads;
+    }
+
+    unsigned getParseThreads() const
+    {
+        return m_parse_threads;
+    }
+
+    const basic_setting<char_type>& getRoot() const
+    {
+        return *this;
+    }
+
+    basic_setting<char_type>& getRoot()
+    {
+        return *this;
+    }
+
+    /*!
+     * \brief compacts the tree and frees the buffers kept for the next read
+     */
+    void compact()
+    {
+        value_type::compact();
+        token_array().swap(m_scratch.tokens);
+        std::vector<size_t>().swap(m_scratch.pairs);
+    }
+
+
+private:
+    class token;
+    typedef std::vector<token> token_array;
+    typedef typename token_array::const_iterator token_iterator;
+    typedef boost::shared_ptr<string_type> string_ptr;
+
+    string_type m_include_dir;
+    int m_options;
+    unsigned m_parse_threads;
+
+#ifdef LIBCONFIGPP_HAS_FUTURES
+    /*!
+     * \brief reads a file into a new config with the settings of another one
+     */
+    class load_request
+    {
+    public:
+        load_request(const basic_config& config, const string_type& path,
+                     const ParseLimits& limits)
+            : m_path(path),
+              m_include_dir(config.m_include_dir),
+              m_options(config.m_options),
+              m_parse_threads(config.m_parse_threads),
+              m_limits(limits)
+        {}
+
+        config_ptr operator()() const
+        {
+            config_ptr config(new basic_config());
+            config->setIncludeDir(m_include_dir);
+            config->setOptions(m_options);
+            config->setParseThreads(m_parse_threads);
+            config->readFile(m_path, m_limits);
+            return config;
+        }
+
+    private:
+        string_type m_path;
+        string_type m_include_dir;
+        int m_options;
+        unsigned m_parse_threads;
+        ParseLimits m_limits;
+    };
+
+    typedef std::packaged_task<config_ptr ()> load_task;
+
+    class load_task_runner
+    {
+    public:
+        explicit load_task_runner(const boost::shared_ptr<load_task>& task)
+            : m_task(task)
+        {}
+
+        void operator()() const
+        {
+            (*m_task)();
+        }
+
+    private:
+        boost::shared_ptr<load_task> m_task;
+    };
+#endif
+
+    class _basic_setting : public value_type
+    {
+    public:
+        _basic_setting(atom_table* atoms, typename value_type::Type type)
+            : value_type(atoms, "", type)
+        {}
+        _basic_setting(atom_table* atoms, const string_type& name,
+                       typename value_type::Type type = value_type::TypeGroup)
+            : value_type(atoms, name, type)
+        {}
+        _basic_setting(const _basic_setting& other)
+            : value_type(other)
+        {}
+        _basic_setting& operator=(const _basic_setting& other)
+        {
+            if (this != &other) {
+                value_type::operator =(other);
+            }
+            return *this;
+        }
+
+        template<typename T>
+        _basic_setting& operator=(const T& value)
+        {
+            value_type::operator =(value);
+            return *this;
+        }
+
+        value_type& add(const _basic_setting &setting)
+        {
+            return value_type::add(setting);
+        }
+    };
+
+    class token : public string_type
+    {
+    public:
+        token() : string_type(), line(0), offset(0), file() {}
+
+        token(const char_type* arg, size_t _line = 0, size_t _offset = 0)
+            : string_type(arg), line(_line), offset(_offset), file()
+        {}
+
+        explicit token(char_type arg, size_t _line = 0, size_t _offset = 0)
+            : string_type(), line(_line), offset(_offset), file()
+        {
+            *this += arg;
+        }
+
+        token(const string_type& arg, size_t _line = 0, size_t _offset = 0)
+            : string_type(arg), line(_line), offset(_offset), file()
+        {}
+
+        template<typename T>
+        token& operator=(const T& other)
+        {
+            string_type::operator =(other);
+            return *this;
+        }
+
+        token& operator=(const token& other)
+        {
+            if (other != *this) {
+                string_type::operator =(other);
+                line = other.line;
+                offset = other.offset;
+                file = other.file;
+            }
+            return *this;
+        }
+
+        void swap(token& other)
+        {
+            string_type::swap(other);
+            std::swap(line, other.line);
+            std::swap(offset, other.offset);
+            file.swap(other.file);
+        }
+
+        size_t line;
+        size_t offset;
+        string_ptr file;
+    };
+
+    class config_tokenizer
+    {
+    public:
+        typedef char_type Char;
+
+        explicit config_tokenizer(size_t max_length = 0)
+            : separators("{}[](),/\\\"=:;"),
+              max_length(max_length)
+        {
+            reset();
+        }
+
+        template<typename InputIterator, typename Token>
+        bool operator()(InputIterator& next, InputIterator& end, Token &tok)
+        {
+            if(!tmp_token.empty()) {
+                tok = tmp_token;
+                tok.line = line;
+                tok.offset = offset;
+                tmp_token.resize(0);
+                return true;
+            }
+
+            bool escape = false;
+            bool is_identifier = false;
             while(next != end) {
                 Char c = skip_comment(next, end);
                 if (c == 0)
@@ -1803,623 +4442,1792 @@ private:
                                         string_type("Unallowed escape token \\") + c,
                                         token(tok, line, offset));
                         }
+                        check_length(tok, tok.size() - 1);
                     } else if (c == '\\') {
                         escape = true;
                     } else {
                         tok += c;
+                        check_length(tok, tok.size() - 1);
+                    }
+                } else if(c == '"') {
+                    is_string = true;
+                    tok = c;
+                    tok.line = line;
+                    tok.offset = offset;
+                } else if(is_identifier) {
+                    if (isspace(c)) {
+                        return true;
+                    } else if(is_in_set(c, separators)) {
+                        tmp_token = c;
+                        return true;
+                    } else {
+                        tok += c;
+                        check_length(tok, tok.size());
+                    }
+                } else if (is_in_set(c, separators)) {
+                    tok = c;
+                    tok.line = line;
+                    tok.offset = offset;
+                    return true;
+                } else if(!isspace(c)) {
+                    tok = c;
+                    tok.line = line;
+                    tok.offset = offset;
+                    is_identifier = true;
+                }
+            }
+            return false;
+        }
+
+        template<typename Token>
+        void check_length(const Token& tok, size_t length)
+        {
+            if (max_length && length > max_length) {
+                throw _syntax_exception("token exceeds the string length limit", tok);
+            }
+        }
+
+        bool is_in_set(Char c, const string_type& set)
+        {
+            for(size_t i = 0; i<set.size(); i++) {
+                if (set[i] == c) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        template<typename T>
+        Char skip_comment(T& next, T&end)
+        {
+            bool simple_comment = false;
+            bool complicated_comment = false;
+            bool escape = false;
+            while(next != end) {
+                Char c = get(next);
+                if(is_string) {
+                    return c;
+                } else if (complicated_comment) {
+                    if (c == '/' && escape) {
+                        complicated_comment = false;
+                        escape = false;
+                    } else if(c == '*') {
+                        escape = true;
+                    } else {
+                        escape = false;
+                    }
+                } else if(simple_comment) {
+                    if (c == '\n') {
+                        simple_comment = false;
+                    }
+                } else if (c == '#') {
+                    simple_comment = true;
+                } else if (c == '/') {
+                    if (next == end) {
+                        throw _syntax_exception("Unexpected end of comment",
+                                                token(c, line, offset));
+                    }
+                    c = get(next);
+                    if (c == '*') {
+                        complicated_comment = true;
+                    } else if (c == '/') {
+                        simple_comment = true;
+                    } else {
+                        throw _syntax_exception(string_type("Unexpected character ") + c,
+                                                token(c, line, offset));
+                    }
+                } else {
+                    return c;
+                }
+            }
+            return 0;
+        }
+
+        template<typename T>
+        Char get(T& s)
+        {
+            Char c = *s++;
+            offset++;
+            if(new_line) {
+                line++;
+                offset = 1;
+                new_line = false;
+            }
+            if (c == '\n') {
+                new_line = true;
+            }
+            return c;
+        }
+
+        void reset()
+        {
+            is_string = false;
+            escape = false;
+            new_line = false;
+            line = 1;
+            offset = 1;
+            tmp_token.resize(0);
+        }
+
+    private:
+        bool is_string;
+        bool escape;
+        bool new_line;
+        size_t line;
+        size_t offset;
+        string_type tmp_token;
+        string_type separators;
+        size_t max_length;
+    };
+
+    /*!
+     * \brief tracks the consumption of ParseLimits shared by all included files
+     */
+    class parse_budget
+    {
+    public:
+        explicit parse_budget(const ParseLimits& _limits)
+            : limits(_limits),
+              bytes(0),
+              includes(0)
+        {}
+
+        void consume_bytes(size_t count, const string_type& file)
+        {
+            bytes += count;
+            if (limits.maxBytes && bytes > limits.maxBytes) {
+                throw ParseException("input exceeds the byte limit", file, 0, 0);
+            }
+        }
+
+        void consume_include(const token& tok)
+        {
+            includes++;
+            if (limits.maxIncludes && includes > limits.maxIncludes) {
+                throw _syntax_exception("include exceeds the include limit", tok);
+            }
+        }
+
+        const ParseLimits limits;
+        size_t bytes;
+        size_t includes;
+    };
+
+    class parser
+    {
+        typedef config_tokenizer tok_func;
+        typedef typename string_type::const_iterator char_iterator;
+        typedef boost::tokenizer<tok_func, char_iterator, token> tokenizer;
+        typedef typename tokenizer::iterator token_iterator;
+
+    public:
+        parser(const string_ptr& file, const string_type& include_dir,
+               size_t level, parse_budget& budget)
+            : m_file(file),
+              m_buffer(read_buffer(*file, budget)),
+              m_include_directory(include_dir),
+              m_deep_level(level),
+              m_budget(budget),
+              m_tokenizer(m_buffer, tok_func(budget.limits.maxStringLength)),
+              it(m_tokenizer.begin()),
+              end(m_tokenizer.end())
+        {}
+
+        parser(const string_type& text, const string_type& include_dir,
+               parse_budget& budget)
+            : m_file(new string_type()),
+              m_buffer(text),
+              m_include_directory(include_dir),
+              m_deep_level(0),
+              m_budget(budget),
+              m_tokenizer(m_buffer, tok_func(budget.limits.maxStringLength)),
+              it(m_tokenizer.begin()),
+              end(m_tokenizer.end())
+        {
+            m_budget.consume_bytes(m_buffer.size(), *m_file);
+        }
+
+        /*!
+         * \brief parse file(s)
+         * \param tokens receives the tokens, included files are read in place
+         */
+        void parse(token_array& tokens)
+        {
+            // replace include with tokens
+            try {
+                bool is_include = false;
+                while(it != end) {
+                    tokens.push_back(*it++);
+                    token& tok = tokens.back();
+                    tok.file = m_file;
+                    if(is_include) {
+                        is_include = false;
+                        token path;
+                        path.swap(tok);
+                        tokens.pop_back();
+                        include(path, tokens);
+                    } else if (tok == "@include") {
+                        is_include = true;
+                        tokens.pop_back();
                     }
-                } else if(c == '"') {
-                    is_string = true;
-                    tok = c;
-                    tok.line = line;
-                    tok.offset = offset;
-                } else if(is_identifier) {
-                    if (isspace(c)) {
-                        return true;
-                    } else if(is_in_set(c, separators)) {
-                        tmp_token = c;
-                        return true;
-                    } else {
-                        tok += c;
+                }
+            } catch(ParseException& ex) {
+                throw _syntax_exception(ex, m_file.get());
+            }
+        }
+
+        /*!
+         * \brief Parse file or files that match patern
+         * \param tok path or pattern
+         * \param tokens receives the tokens from parsed file(s)
+         */
+        void include(const token& tok, token_array& tokens)
+        {
+            using namespace boost;
+            using namespace boost::filesystem;
+
+            string_type _path = _construct_path(_remove_quotes(tok), m_include_directory);
+
+            std::vector<string_ptr> files;
+
+            size_t delimiter = _path.find_last_of('/');
+            if (delimiter == string_type::npos) {
+                files.push_back(string_ptr(new string_type(_path)));
+            } else if (delimiter+1 < _path.size()) {
+                string_type directory = _path.substr(0, delimiter);
+                regex pattern("^" + _path.substr(delimiter + 1) + "$");
+                directory_iterator it(directory);
+                directory_iterator end;
+
+                while(it != end) {
+                    path ptx = *it++;
+                    string_type filename = ptx.filename().generic_string();
+                    if (is_regular_file(ptx) && regex_match(filename, pattern)) {
+                        files.push_back(string_ptr(new string_type(absolute(ptx).generic_string())));
                     }
-                } else if (is_in_set(c, separators)) {
-                    tok = c;
-                    tok.line = line;
-                    tok.offset = offset;
-                    return true;
-                } else if(!isspace(c)) {
-                    tok = c;
-                    tok.line = line;
-                    tok.offset = offset;
-                    is_identifier = true;
                 }
+            } else {
+                throw FileIOException("Can'f find file " + _path);
+            }
+
+            for(size_t i = 0; i<files.size(); i++)
+            {
+                m_budget.consume_include(tok);
+                parser p(files[i], m_include_directory, m_deep_level + 1, m_budget);
+                p.parse(tokens);
+            }
+        }
+
+    private:
+
+        /*!
+         * \brief reads a whole file, charging the budget as it goes
+         * \param path file to read
+         * \return file content, empty if the file can not be opened
+         */
+        static string_type read_buffer(const string_type& path, parse_budget& budget)
+        {
+            std::basic_ifstream<char_type> stream(path.c_str(), std::ios::in | std::ios::binary);
+            string_type buffer;
+            char_type chunk[4096];
+            while(stream.read(chunk, sizeof(chunk) / sizeof(char_type)) || stream.gcount()) {
+                budget.consume_bytes(stream.gcount(), path);
+                buffer.append(chunk, stream.gcount());
+            }
+            return buffer;
+        }
+
+        string_ptr m_file;
+        string_type m_buffer;
+        string_type m_include_directory;
+        size_t m_deep_level;
+        parse_budget& m_budget;
+        tokenizer m_tokenizer;
+        token_iterator it;
+        token_iterator end;
+    };
+
+    static string_type _construct_path(const string_type& filename, const string_type& include_dir)
+    {
+        if (filename.empty()) {
+            throw std::invalid_argument("Filename is empty");
+        }
+
+        if (filename[0] == '/') {
+            return filename;
+        } else {
+            return include_dir + "/" + filename;
+        }
+    }
+
+    template<typename T>
+    /*!
+     * \brief removes quotes at start and end, if such exist.
+     * \param value value from which quotes should be removed
+     * \return string without quotes at start and end
+     */
+    static T _remove_quotes(const T& value) {
+        if (!value.empty() && value[0] == '"' && value.size() > 2) {
+            return value.substr(1, value.size() - 2);
+        }
+        return value;
+    }
+
+    /*!
+     * \brief concatenates adjacent strings in place
+     * \param tokens tokens, compacted to the concatenated strings
+     */
+    static void _concat_string(token_array& tokens, size_t max_length)
+    {
+        BOOST_ASSERT(!tokens.empty());
+
+        size_t last = 0;
+        for(size_t i=1; i<tokens.size(); i++) {
+            token& prev = tokens[last];
+            token& cur = tokens[i];
+            if (prev[0] == '"' && cur[0] == '"') {
+                prev.erase(prev.size() - 1);
+                prev.append(cur, 1, string_type::npos);
+                if (max_length && prev.size() - 2 > max_length) {
+                    throw _syntax_exception("string exceeds the string length limit", prev);
+                }
+            } else if (++last != i) {
+                tokens[last].swap(cur);
+            }
+        }
+        tokens.erase(tokens.begin() + last + 1, tokens.end());
+    }
+
+    /*!
+     * \brief buffers of the last read, kept to be reused by the next one
+     *
+     * Reading a config allocates a token array and a brace index as large
+     * as the file. Once a read is done, its buffers are cleared and handed
+     * back here, so that a config that is read again and again reuses the
+     * same memory. A lazily parsed tree keeps its buffers until it is
+     * fully loaded, the next read then allocates new ones.
+     */
+    struct parse_scratch
+    {
+        token_array tokens;
+        std::vector<size_t> pairs;
+    };
+
+    /*!
+     * \brief tokens of one read together with their structural index
+     *
+     * The index maps every opening brace to its closing brace, so that
+     * groups, lists and arrays can be skipped or parsed independently.
+     * Deferred subtrees keep the context alive until they are loaded.
+     */
+    class parse_context
+    {
+    public:
+        parse_context(parse_scratch& scratch, int _options, unsigned _threads,
+                      const boost::shared_ptr<atom_table>& _atoms, const ParseLimits& limits)
+            : options(_options),
+              threads(_threads),
+              atoms(_atoms)
+        {
+            tokens.swap(scratch.tokens);
+            pairs.swap(scratch.pairs);
+            index(limits);
+        }
+
+        /*!
+         * \brief hands the buffers back once nothing refers to the tokens
+         */
+        void release(parse_scratch& scratch)
+        {
+            tokens.clear();
+            tokens.swap(scratch.tokens);
+            pairs.swap(scratch.pairs);
+        }
+
+        /*!
+         * \brief finds the closing brace for an opening brace
+         * \param opener iterator to an opening brace
+         * \return iterator to the matching closing brace
+         */
+        token_iterator pair(token_iterator opener) const
+        {
+            token_iterator first = tokens.begin();
+            return first + pairs[opener - first];
+        }
+
+        /*!
+         * \brief returns the atom of the file a token was read from
+         */
+        typename value_type::atom_type file(const token& tok) const
+        {
+            typename file_map::const_iterator it = files.find(tok.file.get());
+            return it != files.end() ? it->second : 0;
+        }
+
+        token_array tokens;
+        int options;
+        unsigned threads;
+        boost::shared_ptr<atom_table> atoms;    //!< names of the config being read
+
+    private:
+        typedef boost::unordered_map<const string_type*, typename value_type::atom_type> file_map;
+
+        /*!
+         * \brief matches braces, checking the depth and node limits on the way
+         *
+         * A node is counted for every assignment and for every item of a
+         * list or array.
+         */
+        void index(const ParseLimits& limits)
+        {
+            std::vector<size_t> stack;
+            bool item = false;
+            size_t nodes = 0;
+            pairs.assign(tokens.size(), 0);
+            for(size_t i=0; i<tokens.size(); i++) {
+                const token& tok = tokens[i];
+                if (tok.file && files.find(tok.file.get()) == files.end()) {
+                    files.insert(std::make_pair(tok.file.get(), atoms->intern(*tok.file)));
+                }
+                bool in_list = !stack.empty() && tokens[stack.back()] != "{";
+                if (tok == "=" || tok == ":") {
+                    nodes++;
+                } else if (in_list && tok == ",") {
+                    item = false;
+                } else if (in_list && !item && tok != ")" && tok != "]") {
+                    nodes++;
+                    item = true;
+                }
+                if (limits.maxNodes && nodes > limits.maxNodes) {
+                    throw _syntax_exception("configuration exceeds the node limit", tok);
+                }
+
+                if (tok == "{" || tok == "(" || tok == "[") {
+                    stack.push_back(i);
+                    item = false;
+                    if (limits.maxDepth && stack.size() > limits.maxDepth) {
+                        throw _syntax_exception("configuration exceeds the depth limit", tok);
+                    }
+                } else if (tok == "}" || tok == ")" || tok == "]") {
+                    if (stack.empty()) {
+                        throw _syntax_exception("unmatched brace " + tok, tok);
+                    }
+                    const token& open = tokens[stack.back()];
+                    if ((open == "{" && tok != "}") || (open == "(" && tok != ")") ||
+                            (open == "[" && tok != "]")) {
+                        throw _syntax_exception("unable to find closing tag of " + open, open);
+                    }
+                    pairs[stack.back()] = i;
+                    stack.pop_back();
+                    item = true;
+                }
+            }
+            if (!stack.empty()) {
+                const token& open = tokens[stack.back()];
+                throw _syntax_exception("unable to find closing tag of " + open, open);
+            }
+        }
+
+        std::vector<size_t> pairs;
+        file_map files;     //!< file atoms by the file pointer shared by its tokens
+    };
+
+    typedef boost::shared_ptr<const parse_context> context_ptr;
+
+    /*!
+     * \brief loads the children of a group, list or array on demand
+     */
+    class deferred_loader
+    {
+    public:
+        typedef void (*load_function)(const context_ptr&, token_iterator, token_iterator,
+                                      value_type&);
+
+        deferred_loader(load_function load, const context_ptr& ctx,
+                        token_iterator begin, token_iterator end)
+            : m_load(load), m_ctx(ctx), m_begin(begin), m_end(end)
+        {}
+
+        void operator()(value_type& target) const
+        {
+            m_load(m_ctx, m_begin, m_end, target);
+        }
+
+    private:
+        load_function m_load;
+        context_ptr m_ctx;
+        token_iterator m_begin;
+        token_iterator m_end;
+    };
+
+    parse_scratch m_scratch;
+
+    void _read(parser& p, const ParseLimits& limits, value_type& root)
+    {
+        token_array& tokens = m_scratch.tokens;
+        tokens.clear();
+        p.parse(tokens);
+        if (!tokens.empty()) {
+            _concat_string(tokens, limits.maxStringLength);
+            boost::shared_ptr<parse_context> ctx(new parse_context(m_scratch, m_options,
+                                                                   m_parse_threads,
+                                                                   atom_holder::member, limits));
+            _load_group(ctx, ctx->tokens.begin(), ctx->tokens.end(), root);
+            // deferred loaders keep the context, and with it the tokens
+            if (ctx.unique()) {
+                ctx->release(m_scratch);
+            }
+        }
+    }
+
+    static void _load_group(const context_ptr& ctx, token_iterator begin, token_iterator end,
+                            value_type& group)
+    {
+#ifdef LIBCONFIGPP_HAS_THREADS
+        if (_parallel(ctx, begin, end)) {
+            _load_parallel(ctx, _split_group(begin, end, ctx), group);
+            return;
+        }
+#endif
+        _load_settings(ctx, begin, end, group);
+    }
+
+    static void _load_list(const context_ptr& ctx, token_iterator begin, token_iterator end,
+                           value_type& list)
+    {
+#ifdef LIBCONFIGPP_HAS_THREADS
+        if (_parallel(ctx, begin, end)) {
+            _load_parallel(ctx, _split_list(begin, end, ctx), list);
+            return;
+        }
+#endif
+        _load_items(ctx, begin, end, list);
+    }
+
+#ifdef LIBCONFIGPP_HAS_THREADS
+    /*!
+     * \brief contiguous range of settings or list items parsed by one thread
+     */
+    struct parse_chunk
+    {
+        token_iterator begin;
+        token_iterator end;
+        boost::shared_ptr<_basic_setting> settings;    //!< parsed children, moved to the target
+        std::exception_ptr error;
+    };
+
+    typedef std::vector<parse_chunk> chunk_array;
+
+    /*!
+     * \brief minimal number of tokens handed to a parser thread
+     */
+    static size_t _parallel_grain()
+    {
+        return 4096;
+    }
+
+    static bool& _is_parse_worker()
+    {
+        static thread_local bool worker = false;
+        return worker;
+    }
+
+    static unsigned _parse_threads(const context_ptr& ctx)
+    {
+        if (ctx->threads) {
+            return ctx->threads;
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    static bool _parallel(const context_ptr& ctx, token_iterator begin, token_iterator end)
+    {
+        return (ctx->options & OptionParallelParse) && !_is_parse_worker() &&
+                _parse_threads(ctx) > 1 &&
+                static_cast<size_t>(end - begin) >= 2 * _parallel_grain();
+    }
+
+    /*!
+     * \brief skips one setting the way _load_setting consumes it
+     * \return false if the setting is malformed and must be left to the serial parser
+     */
+    static bool _skip_setting(const context_ptr& ctx, token_iterator& it, token_iterator end)
+    {
+        const token& identifier = *it;
+        if (identifier == "[" || identifier == "]" || identifier == "{" || identifier == "}" ||
+                identifier == "," || identifier == "=" || identifier == ":") {
+            return false;
+        }
+        if (++it == end || !(*it == "=" || *it == ":") || ++it == end) {
+            return false;
+        }
+        if (*it == "{" || *it == "(" || *it == "[") {
+            it = ctx->pair(it);
+        }
+        ++it;
+        if (it != end && (*it == ";" || *it == ",")) {
+            ++it;
+        }
+        return true;
+    }
+
+    /*!
+     * \brief groups the settings of a range into chunks of at least one grain
+     *
+     * Splitting stops at the first malformed setting, the rest of the range
+     * then forms the last chunk and reports the error as the serial path does.
+     */
+    static chunk_array _split_group(token_iterator begin, token_iterator end,
+                                    const context_ptr& ctx)
+    {
+        size_t grain = std::max(_parallel_grain(),
+                                static_cast<size_t>(end - begin) / _parse_threads(ctx));
+        chunk_array chunks;
+        token_iterator first = begin;
+        token_iterator it = begin;
+        while(it != end && _skip_setting(ctx, it, end)) {
+            if (static_cast<size_t>(it - first) >= grain) {
+                parse_chunk chunk;
+                chunk.begin = first;
+                chunk.end = it;
+                chunks.push_back(chunk);
+                first = it;
+            }
+        }
+        if (first != end) {
+            parse_chunk chunk;
+            chunk.begin = first;
+            chunk.end = end;
+            chunks.push_back(chunk);
+        }
+        return chunks;
+    }
+
+    /*!
+     * \brief groups the items of a list or array into chunks of at least one grain
+     *
+     * Chunks start at an item separator, like the range given to _load_list.
+     */
+    static chunk_array _split_list(token_iterator begin, token_iterator end,
+                                   const context_ptr& ctx)
+    {
+        size_t grain = std::max(_parallel_grain(),
+                                static_cast<size_t>(end - begin) / _parse_threads(ctx));
+        chunk_array chunks;
+        token_iterator first = begin;
+        token_iterator it = begin;
+        while(it != end) {
+            it = _find_list_item(ctx, it + 1, end);
+            if (it != end && static_cast<size_t>(it - first) >= grain) {
+                parse_chunk chunk;
+                chunk.begin = first;
+                chunk.end = it;
+                chunks.push_back(chunk);
+                first = it;
+            }
+        }
+        parse_chunk chunk;
+        chunk.begin = first;
+        chunk.end = end;
+        chunks.push_back(chunk);
+        return chunks;
+    }
+
+    static void _parse_chunk(const context_ptr& ctx, parse_chunk* chunk)
+    {
+        _is_parse_worker() = true;
+        try {
+            if (chunk->settings->isGroup()) {
+                _load_settings(ctx, chunk->begin, chunk->end, *chunk->settings);
+            } else {
+                _load_items(ctx, chunk->begin, chunk->end, *chunk->settings);
+            }
+        } catch (...) {
+            chunk->error = std::current_exception();
+        }
+    }
+
+    /*!
+     * \brief parses chunks on separate threads and moves the results in order
+     *
+     * Each chunk is parsed into a setting of the target's type. The chunks
+     * are moved in order, and the error of a chunk is only rethrown once its
+     * settings up to the error are moved. A name repeated from an earlier
+     * chunk is therefore reported before a later parse error, as the serial
+     * parser reports it.
+     */
+    static void _load_parallel(const context_ptr& ctx, chunk_array chunks,
+                               value_type& target)
+    {
+        std::vector<std::thread> threads;
+        for(size_t i=0; i<chunks.size(); i++) {
+            chunks[i].settings.reset(new _basic_setting(ctx->atoms.get(), target.getType()));
+            try {
+                threads.push_back(std::thread(&basic_config::_parse_chunk, ctx, &chunks[i]));
+            } catch (std::exception&) {
+                _parse_chunk(ctx, &chunks[i]);
+                _is_parse_worker() = false;
+            }
+        }
+        for(size_t i=0; i<threads.size(); i++) {
+            threads[i].join();
+        }
+
+        for(size_t i=0; i<chunks.size(); i++) {
+            target._splice(*chunks[i].settings);
+            if (chunks[i].error) {
+                std::rethrow_exception(chunks[i].error);
+            }
+        }
+    }
+#endif
+
+    /*!
+     * \brief parses the settings of a group into group
+     */
+    static void _load_settings(const context_ptr& ctx, token_iterator begin, token_iterator end,
+                               value_type& group)
+    {
+        while(begin != end) {
+            token tok = *begin++;
+            if(tok == "[" || tok == "]") {
+                throw _syntax_exception("unexpected array", tok);
+            } else if(tok == "{" || tok == "}") {
+                throw _syntax_exception("unexpected group setting without identifier", tok);
+            } else if(tok == "," || tok == "=" || tok == ":") {
+                throw _syntax_exception("unexpected token " + tok, tok);
+            } else {
+                _load_setting(ctx, tok, begin, end, group);
+            }
+        }
+    }
+
+    /*!
+     * \brief parses the items of a list or array into list
+     * \param begin opening brace or item separator in front of the first item
+     */
+    static void _load_items(const context_ptr& ctx, token_iterator begin, token_iterator end,
+                            value_type& list)
+    {
+        token_iterator _last = begin;
+        while(begin != end) {
+            _last = ++begin;
+            begin = _find_list_item(ctx, begin, end);
+            if(_last != begin)
+                _load_value(ctx, token(), _last, begin, list);
+        }
+    }
+
+    static void _load_setting(const context_ptr& ctx, const token& identifier,
+                              token_iterator& begin, token_iterator& end, value_type& group)
+    {
+        if (begin != end) {
+            token tok = *begin++;
+            if (tok == "=" || tok == ":") {
+                if (begin != end) {
+                    _load_value(ctx, identifier, begin, end, group);
+                    begin = _skip_end(begin, end);
+                } else {
+                    throw _syntax_exception("unexpected end of file", tok, true);
+                }
+            } else {
+                throw _syntax_exception("unexpected token " + tok, tok);
             }
-            return false;
+        } else {
+            throw _syntax_exception("unexpected end of file", identifier, true);
+        }
+    }
+
+    /*!
+     * \brief parses the value at begin straight into a new child of parent
+     * \param name name of the child, empty for list items
+     * \param begin value to parse, moved behind it
+     */
+    static void _load_value(const context_ptr& ctx, const token& name,
+                            token_iterator& begin, token_iterator end, value_type& parent)
+    {
+        const token& tok = *begin;
+        if (tok == "{") {
+            _load_aggregate(&_load_group, value_type::TypeGroup, ctx, name, begin, end, parent);
+        } else if (tok == "(") {
+            _load_aggregate(&_load_list, value_type::TypeList, ctx, name, begin, end, parent);
+        } else if (tok == "[") {
+            _load_aggregate(&_load_list, value_type::TypeArray, ctx, name, begin, end, parent);
+        } else {
+            _load_scalar(ctx, name, *begin++, parent);
+        }
+    }
+
+    static void _load_aggregate(typename deferred_loader::load_function load, config_type type,
+                                const context_ptr& ctx, const token& name,
+                                token_iterator& begin, token_iterator end, value_type& parent)
+    {
+        token_iterator _begin = begin;
+        token_iterator _end = ctx->pair(_begin);
+
+        begin = _end;
+        if (begin != end) {
+            ++begin;
+        }
+
+        value_type& setting = parent._emplace(name, type);
+        _locate(ctx, name, *_begin, setting);
+        if (type == value_type::TypeGroup) {
+            ++_begin;
+        }
+        _load(load, ctx, _begin, _end, setting);
+    }
+
+    /*!
+     * \brief records where a setting was read, at its name unless it has none
+     */
+    static void _locate(const context_ptr& ctx, const token& name, const token& value,
+                        value_type& setting)
+    {
+        const token& tok = name.file ? name : value;
+        setting.m_file = ctx->file(tok);
+        setting.m_line = tok.line;
+    }
+
+    /*!
+     * \brief fills an aggregate now or, with OptionLazyParse, on first access
+     */
+    static void _load(typename deferred_loader::load_function load, const context_ptr& ctx,
+                      token_iterator begin, token_iterator end, value_type& target)
+    {
+        if (ctx->options & OptionLazyParse) {
+            target.defer(deferred_loader(load, ctx, begin, end));
+        } else {
+            load(ctx, begin, end, target);
+        }
+    }
+
+    static config_type _get_scalar_type(const token& value)
+    {
+        using namespace std;
+        using namespace boost;
+
+        regex rx_boolean("^([Tt][Rr][Uu][Ee])|([Ff][Aa][Ll][Ss][Ee])$");
+        regex rx_int("^[-+]?[0-9]+$");
+        regex rx_int64("^[-+]?[0-9]+L(L)?$");
+        regex rx_hex("^0[Xx][0-9A-Fa-f]+$");
+        regex rx_hex64("^0[Xx][0-9A-Fa-f]+L(L)?$");
+        regex rx_float("^([-+]?([0-9]*)?\\.[0-9]*([eE][-+]?[0-9]+)?)|"
+                       "([-+]?([0-9]+)(\\.[0-9]*)?[eE][-+]?[0-9]+)$");
+
+        if (value[0] == '"') {
+            return value_type::TypeString;
+        } else if (regex_match(value, rx_boolean)) {
+            return value_type::TypeBoolean;
+        } else if (regex_match(value, rx_int)) {
+            return value_type::TypeInt;
+        } else if (regex_match(value, rx_hex)) {
+            return value_type::TypeInt;
+        } else if (regex_match(value, rx_int64)) {
+            return value_type::TypeInt64;
+        } else if (regex_match(value, rx_hex64)) {
+            return value_type::TypeInt64;
+        } else if (regex_match(value, rx_float)) {
+            return value_type::TypeFloat;
+        } else {
+            return value_type::TypeGroup;
+        }
+    }
+
+    /*!
+     * \brief parses a scalar into a new child of parent
+     *
+     * Numbers keep their text and, unless OptionLazyScalars is set, are
+     * converted right away. Array elements are parsed into a temporary,
+     * since they are stored packed.
+     */
+    static void _load_scalar(const context_ptr& ctx, const token& name, const token& value,
+                             value_type& parent)
+    {
+        config_type type = _get_scalar_type(value);
+        if (type == value_type::TypeGroup) {
+            throw _syntax_exception("invalid value " + value, value);
+        }
+
+        if (parent.isArray()) {
+            _basic_setting element(ctx->atoms.get(), name, type);
+            _set_scalar(ctx, name, value, element);
+            parent.append(element);
+        } else {
+            _set_scalar(ctx, name, value, parent._emplace(name, type));
+        }
+    }
+
+    static void _set_scalar(const context_ptr& ctx, const token& name, const token& value,
+                            value_type& setting)
+    {
+        _locate(ctx, name, value, setting);
+        switch(setting.getType())
+        {
+        case value_type::TypeString:
+            setting = _remove_quotes(value);
+            break;
+        case value_type::TypeInt:
+        case value_type::TypeInt64:
+            // the type was matched by a pattern, a 0x prefix is all that marks hex
+            if (value.size() > 1 && (value[1] == 'x' || value[1] == 'X')) {
+                setting.setFormat(value_type::FormatHex);
+            }
+            // fall through
+        default:
+            setting.m_scalar.setText(value);
+            if (!(ctx->options & OptionLazyScalars)) {
+                setting.m_scalar.resolve();
+            }
+        }
+    }
+
+    static token_iterator _skip_end(token_iterator& begin, token_iterator& end)
+    {
+        if (begin != end && (*begin == ";" || *begin == ",")) {
+            return ++begin;
+        }
+        return begin;
+    }
+
+    static token_iterator _find_list_item(const context_ptr& ctx, token_iterator begin,
+                                          token_iterator end)
+    {
+        token_iterator _it(begin);
+
+        while(_it != end) {
+            const token& tok = *_it;
+            if (tok == "[" || tok == "{" || tok == "(") {
+                _it = ctx->pair(_it);
+            } else if (tok == ",") {
+                return _it;
+            }
+            ++_it;
+        }
+
+        return end;
+    }
+
+    static ParseException _syntax_exception(const string_type& msg, const token& tok,
+                                            bool offset_at_end_of_token = false)
+    {
+        std::ostringstream ss;
+        ss << msg;
+        size_t offset = tok.offset;
+        if (offset_at_end_of_token)
+            offset += tok.size();
+
+        string_type file;
+        if (tok.file) {
+            file = *tok.file;
+        }
+
+        return ParseException(ss.str(), file, tok.line, tok.offset);
+    }
+
+    static ParseException _syntax_exception(const ParseException& ex, const string_type* file)
+    {
+        return ParseException(ex.what(), *file, ex.line(), ex.offset());
+    }
+};
+
+/*!
+ * \brief writes configuration syntax to a stream without building a tree
+ *
+ * Settings are written in call order, formatted as basic_setting::print
+ * formats them. Scalars are written with scalar(), groups, lists and
+ * arrays are opened with begin and closed with end calls. Settings
+ * directly inside a group need a name that is unique in the group and
+ * can be read back as part of a path, list and array elements have none.
+ * finish() checks that all aggregates are closed.
+ */
+template<typename charT>
+class basic_config_writer
+{
+public:
+    typedef charT char_type;
+    typedef std::basic_string<charT> string_type;
+    typedef basic_setting<char_type> setting_type;
+    typedef typename setting_type::Type Type;
+    typedef typename setting_type::Format Format;
+
+    explicit basic_config_writer(std::basic_ostream<char_type>& out)
+        : m_out(out)
+    {
+        m_frames.push_back(frame(setting_type::TypeGroup, 0));
+    }
+
+    basic_config_writer& beginGroup(const string_type& name = string_type())
+    {
+        return _begin(name, setting_type::TypeGroup);
+    }
+
+    basic_config_writer& endGroup()
+    {
+        return _end(setting_type::TypeGroup);
+    }
+
+    basic_config_writer& beginList(const string_type& name = string_type())
+    {
+        return _begin(name, setting_type::TypeList);
+    }
+
+    basic_config_writer& endList()
+    {
+        return _end(setting_type::TypeList);
+    }
+
+    basic_config_writer& beginArray(const string_type& name = string_type())
+    {
+        return _begin(name, setting_type::TypeArray);
+    }
+
+    basic_config_writer& endArray()
+    {
+        return _end(setting_type::TypeArray);
+    }
+
+    basic_config_writer& scalar(const string_type& name, bool value)
+    {
+        _entry(name, setting_type::TypeBoolean);
+        m_out << value;
+        return _entry_end();
+    }
+
+    basic_config_writer& scalar(const string_type& name, int value,
+                                Format format = setting_type::FormatDefault)
+    {
+        _entry(name, setting_type::TypeInt);
+        if (format == setting_type::FormatHex) {
+            m_out << "0x" << std::hex;
         }
+        m_out << value << std::dec;
+        return _entry_end();
+    }
 
-        bool is_in_set(Char c, const string_type& set)
-        {
-            for(size_t i = 0; i<set.size(); i++) {
-                if (set[i] == c) {
-                    return true;
-                }
-            }
-            return false;
+    basic_config_writer& scalar(const string_type& name, long value,
+                                Format format = setting_type::FormatDefault)
+    {
+        _entry(name, setting_type::TypeInt64);
+        if (format == setting_type::FormatHex) {
+            m_out << "0x" << std::hex;
         }
+        m_out << value << "L" << std::dec;
+        return _entry_end();
+    }
 
-        template<typename T>
-        Char skip_comment(T& next, T&end)
-        {
-            bool simple_comment = false;
-            bool complicated_comment = false;
-            bool escape = false;
-            while(next != end) {
-                Char c = get(next);
-                if(is_string) {
-                    return c;
-                } else if (complicated_comment) {
-                    if (c == '/' && escape) {
-                        complicated_comment = false;
-                        escape = false;
-                    } else if(c == '*') {
-                        escape = true;
-                    } else {
-                        escape = false;
-                    }
-                } else if(simple_comment) {
-                    if (c == '\n') {
-                        simple_comment = false;
-                    }
-                } else if (c == '#') {
-                    simple_comment = true;
-                } else if (c == '/') {
-                    if (next == end) {
-                        throw _syntax_exception("Unexpected end of comment",
-                                                token(c, line, offset));
-                    }
-                    c = get(next);
-                    if (c == '*') {
-                        complicated_comment = true;
-                    } else if (c == '/') {
-                        simple_comment = true;
-                    } else {
-                        throw _syntax_exception(string_type("Unexpected character ") + c,
-                                                token(c, line, offset));
-                    }
-                } else {
-                    return c;
-                }
+    basic_config_writer& scalar(const string_type& name, float value)
+    {
+        _entry(name, setting_type::TypeFloat);
+        m_out << value;
+        return _entry_end();
+    }
+
+    basic_config_writer& scalar(const string_type& name, double value)
+    {
+        return scalar(name, static_cast<float>(value));
+    }
+
+    basic_config_writer& scalar(const string_type& name, const string_type& value)
+    {
+        _entry(name, setting_type::TypeString);
+        m_out << '"' << value << '"';
+        return _entry_end();
+    }
+
+    basic_config_writer& scalar(const string_type& name, const char_type* value)
+    {
+        return scalar(name, string_type(value));
+    }
+
+    /*!
+     * \brief checks that all aggregates are closed and flushes the stream
+     */
+    void finish()
+    {
+        if (m_frames.size() != 1) {
+            throw ConfigException("unterminated group, list or array");
+        }
+        if (m_frames.back().count == 0) {
+            m_out << "{}";
+            m_frames.back().count++;
+        }
+        m_out.flush();
+    }
+
+private:
+    struct frame
+    {
+        frame(Type _type, size_t _level)
+            : type(_type), level(_level), count(0), element(setting_type::TypeGroup)
+        {}
+
+        Type type;
+        size_t level;
+        size_t count;
+        Type element;
+        boost::unordered_set<string_type> names;    //!< members written so far, for groups
+    };
+
+    /*!
+     * \brief checks that name can be read back as one name of a path
+     */
+    static bool _valid_name(const string_type& name)
+    {
+        static const char separators[] = "{}[](),/\\\"=:;.#";
+        for (size_t i = 0; i < name.size(); i++) {
+            if (std::isspace(name[i], std::locale::classic()) ||
+                    std::find(separators, separators + sizeof(separators) - 1, name[i])
+                        != separators + sizeof(separators) - 1) {
+                return false;
             }
-            return 0;
         }
+        return true;
+    }
 
-        template<typename T>
-        Char get(T& s)
-        {
-            Char c = *s++;
-            offset++;
-            if(new_line) {
-                line++;
-                offset = 1;
-                new_line = false;
+    basic_config_writer& _begin(const string_type& name, Type type)
+    {
+        _entry(name, type);
+        if (type == setting_type::TypeArray) {
+            m_out << "[";
+        }
+        m_frames.push_back(frame(type, m_frames.back().level + 1));
+        return *this;
+    }
+
+    basic_config_writer& _end(Type type)
+    {
+        frame& current = m_frames.back();
+        if (m_frames.size() == 1 || current.type != type) {
+            throw ConfigException("unbalanced end of group, list or array");
+        }
+
+        string_type ident((current.level - 1) * 4, ' ');
+        switch(type) {
+        case setting_type::TypeGroup:
+            m_out << (current.count ? ident + "}" : string_type("{}"));
+            break;
+        case setting_type::TypeList:
+            m_out << (current.count ? ident + ")" : string_type("()"));
+            break;
+        default:
+            m_out << "]";
+        }
+        m_frames.pop_back();
+        return _entry_end();
+    }
+
+    /*!
+     * \brief writes separators, indentation and name in front of a setting
+     */
+    void _entry(const string_type& name, Type type)
+    {
+        frame& parent = m_frames.back();
+        string_type ident(parent.level * 4, ' ');
+
+        switch(parent.type) {
+        case setting_type::TypeGroup:
+            if (name.empty()) {
+                throw SettingNameException("settings of a group need a name", name);
+            } else if (!_valid_name(name)) {
+                throw SettingNameException("invalid setting name", name);
+            } else if (!parent.names.insert(name).second) {
+                throw SettingNameException(name + " already exists", name);
             }
-            if (c == '\n') {
-                new_line = true;
+            if (parent.count == 0 && m_frames.size() > 1) {
+                m_out << "{\n";
+            }
+            m_out << ident << name << " = ";
+            break;
+        case setting_type::TypeList:
+            if (!name.empty()) {
+                throw SettingNameException("list elements can not have a name", name);
+            }
+            m_out << (parent.count == 0 ? string_type("(\n") : ident + ",\n") << ident;
+            break;
+        default:
+            if (!name.empty()) {
+                throw SettingNameException("array elements can not have a name", name);
+            }
+            if (type == setting_type::TypeArray || type == setting_type::TypeList ||
+                    type == setting_type::TypeGroup) {
+                throw SettingTypeException("Array elements must be scalar values", name);
+            }
+            if (parent.count != 0 && parent.element != type) {
+                throw SettingTypeException("Array elements must have same type", name);
+            }
+            parent.element = type;
+            if (parent.count != 0) {
+                m_out << ", ";
             }
-            return c;
         }
+    }
 
-        void reset()
-        {
-            is_string = false;
-            escape = false;
-            new_line = false;
-            line = 1;
-            offset = 1;
-            tmp_token.resize(0);
+    basic_config_writer& _entry_end()
+    {
+        frame& parent = m_frames.back();
+        switch(parent.type) {
+        case setting_type::TypeGroup:
+            m_out << ";\n";
+            break;
+        case setting_type::TypeList:
+            m_out << "\n";
+            break;
+        default:
+            break;
         }
+        parent.count++;
+        return *this;
+    }
 
-    private:
-        bool is_string;
-        bool escape;
-        bool new_line;
-        size_t line;
-        size_t offset;
-        string_type tmp_token;
-        string_type separators;
-    };
+    std::basic_ostream<char_type>& m_out;
+    std::vector<frame> m_frames;
+};
 
-    class parser
-    {
-        typedef config_tokenizer tok_func;
-        typedef std::istream_iterator<char_type, char_type> char_iterator;
-        typedef boost::tokenizer<tok_func, char_iterator, token> tokenizer;
-        typedef typename tokenizer::iterator token_iterator;
+/*!
+ * \brief read-only copy of a setting tree stored as one flat table
+ *
+ * Nodes are numbered in preorder and kept column by column: type, format,
+ * name id, parent and scalar payload. The children of each aggregate are
+ * one contiguous range of node ids, and the members of groups are also
+ * hashed by group and name id for lookups. A walk over the table reads a
+ * few dense vectors instead of following one heap object per setting.
+ * Settings are accessed through view, which mirrors the read-only part of
+ * basic_setting.
+ */
+template<typename charT>
+class basic_setting_table
+{
+public:
+    typedef charT char_type;
+    typedef typename std::basic_string<charT> string_type;
+    typedef basic_setting<charT> setting_type;
+    typedef typename setting_type::Type Type;
+    typedef typename setting_type::Format Format;
+    typedef size_t node_id;
+
+    static const node_id npos = static_cast<node_id>(-1);
 
+    /*!
+     * \brief handle of one node in a basic_setting_table
+     *
+     * A view is two words and is passed by value. It stays valid as long
+     * as the table it was taken from.
+     */
+    class view
+    {
     public:
-        parser(const string_ptr& file, const string_type& include_dir,
-               size_t level)
-            : m_file(file),
-              m_stream(file->c_str()),
-              m_include_directory(include_dir),
-              m_deep_level(level),
-              m_tokenizer(get_iterator(m_stream), char_iterator(), tok_func()),
-              it(m_tokenizer.begin()),
-              end(m_tokenizer.end())
+        view(const basic_setting_table& table, node_id node)
+            : m_table(&table),
+              m_node(node)
         {}
 
+        node_id getId() const
+        {
+            return m_node;
+        }
+
+        string_type getName() const
+        {
+            return m_table->m_name_pool[m_table->m_names[m_node]];
+        }
+
         /*!
-         * \brief parse file(s)
-         * \return tokens
+         * \brief returns the names from the root down to this node joined
+         * by dots, the root and array elements have an empty name
          */
-        token_array parse()
+        string_type getPath() const
         {
-            // replace include with tokens
-            try {
-                token_array tokens;
-                bool is_include = false;
-                while(it != end) {
-                    token tok = *it++;
-                    tok.file = m_file;
-                    if(is_include) {
-                        is_include = false;
-                        token_array _tokens = include(tok);
-                        tokens.insert(tokens.end(), _tokens.begin(), _tokens.end());
-                    } else if (tok == "@include") {
-                        is_include = true;
-                    } else {
-                        tokens.push_back(tok);
-                    }
+            std::vector<node_id> nodes;
+            for (node_id node = m_node; node != npos; node = m_table->m_parents[node]) {
+                nodes.push_back(node);
+            }
+            string_type path;
+            for (size_t i = nodes.size(); i-- > 0; ) {
+                if (!path.empty()) {
+                    path += '.';
                 }
-                return tokens;
-            } catch(ParseException& ex) {
-                throw _syntax_exception(ex, m_file.get());
+                path += m_table->m_name_pool[m_table->m_names[nodes[i]]];
             }
+            return path;
         }
 
-        /*!
-         * \brief Parse file or files that match patern
-         * \param _path path or pattern
-         * \return tokens from parsed file(s)
-         */
-        token_array include(string_type _path)
+        Type getType() const
         {
-            using namespace boost;
-            using namespace boost::filesystem;
+            return m_table->m_types[m_node];
+        }
 
-            _path = _construct_path(_remove_quotes(_path), m_include_directory);
+        Format getFormat() const
+        {
+            return m_table->m_formats[m_node];
+        }
 
-            std::vector<string_ptr> files;
+        size_t getLength() const
+        {
+            return m_table->m_child_count[m_node];
+        }
 
-            size_t delimiter = _path.find_last_of('/');
-            if (delimiter == string_type::npos) {
-                files.push_back(string_ptr(new string_type(_path)));
-            } else if (delimiter+1 < _path.size()) {
-                string_type directory = _path.substr(0, delimiter);
-                regex pattern("^" + _path.substr(delimiter + 1) + "$");
-                directory_iterator it(directory);
-                directory_iterator end;
+        bool isRoot() const
+        {
+            return m_table->m_parents[m_node] == npos;
+        }
 
-                while(it != end) {
-                    path ptx = *it++;
-                    string_type filename = ptx.filename().generic_string();
-                    if (is_regular_file(ptx) && regex_match(filename, pattern)) {
-                        files.push_back(string_ptr(new string_type(absolute(ptx).generic_string())));
-                    }
-                }
-            } else {
-                throw FileIOException("Can'f find file " + _path);
+        view getParent() const
+        {
+            node_id parent = m_table->m_parents[m_node];
+            if (parent == npos) {
+                throw _not_found_ex("parent");
             }
+            return view(*m_table, parent);
+        }
 
-            token_array tokens;
-            for(size_t i = 0; i<files.size(); i++)
-            {
-                parser p(files[i], m_include_directory, m_deep_level + 1);
-                token_array _tokens = p.parse();
-                tokens.insert(tokens.end(), _tokens.begin(), _tokens.end());
+        int getIndex() const
+        {
+            node_id parent = m_table->m_parents[m_node];
+            if (parent == npos) {
+                return -1;
+            }
+            // children are numbered in preorder, so their ids are sorted
+            const node_id* first = m_table->_children(parent);
+            const node_id* last = first + m_table->m_child_count[parent];
+            return std::lower_bound(first, last, m_node) - first;
+        }
+
+        bool isGroup() const
+        {
+            return getType() == setting_type::TypeGroup;
+        }
+
+        bool isArray() const
+        {
+            return getType() == setting_type::TypeArray;
+        }
+
+        bool isList() const
+        {
+            return getType() == setting_type::TypeList;
+        }
+
+        bool isAggredate() const
+        {
+            return isGroup() || isArray() || isList();
+        }
+
+        bool isScalar() const
+        {
+            return !isAggredate();
+        }
+
+        bool isNumber() const
+        {
+            switch (getType()) {
+            case setting_type::TypeInt:
+            case setting_type::TypeInt64:
+            case setting_type::TypeFloat:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        view operator[](int index) const
+        {
+            if(index < 0) {
+                throw std::invalid_argument("Index can not be negative number");
             }
-            return tokens;
+            node_id child = m_table->_find(m_node, index);
+            if (child == npos) {
+                std::basic_ostringstream<char_type> ss;
+                ss << "[" << index << "]";
+                throw _not_found_ex(ss.str());
+            }
+            return view(*m_table, child);
         }
 
-    private:
+        view operator[](const char* path) const
+        {
+            return lookup(path);
+        }
 
-        char_iterator get_iterator(std::ifstream & stream)
+        view operator[](const string_type& path) const
         {
-            stream >> std::noskipws;
-            return char_iterator(stream);
+            return lookup(path);
         }
 
-        string_ptr m_file;
-        std::ifstream m_stream;
-        string_type m_include_directory;
-        size_t m_deep_level;
-        tokenizer m_tokenizer;
-        token_iterator it;
-        token_iterator end;
-    };
+        view lookup(const string_type& path) const
+        {
+            if (path.empty()) {
+                return *this;
+            }
+            node_id node = m_table->_lookup(m_node, path);
+            if (node == npos) {
+                throw _not_found_ex(path);
+            }
+            return view(*m_table, node);
+        }
 
-    static string_type _construct_path(const string_type& filename, const string_type& include_dir)
-    {
-        if (filename.empty()) {
-            throw std::invalid_argument("Filename is empty");
+        bool exists(const string_type& path) const
+        {
+            if(path.empty()) {
+                throw std::invalid_argument("Path is empty");
+            } else if (path[0] == '.' || path[path.size()-1] == '.') {
+                throw std::invalid_argument("Path can not begin or end with dot(.)");
+            }
+            return m_table->_lookup(m_node, path) != npos;
         }
 
-        if (filename[0] == '/') {
-            return filename;
-        } else {
-            return include_dir + "/" + filename;
+        template<typename T>
+        bool lookupValue(const string_type& path, T& value) const
+        {
+            try {
+                value = static_cast<T>(lookup(path));
+                return true;
+            } catch (std::exception&) {
+                return false;
+            }
         }
-    }
 
-    template<typename T>
-    /*!
-     * \brief removes quotes at start and end, if such exist.
-     * \param value value from which quotes should be removed
-     * \return string without quotes at start and end
-     */
-    static T _remove_quotes(const T& value) {
-        if (!value.empty() && value[0] == '"' && value.size() > 2) {
-            return value.substr(1, value.size() - 2);
+        operator bool () const
+        {
+            if (getType() == setting_type::TypeFloat) {
+                return _payload().floating != 0;
+            }
+            return _integer() != 0;
         }
-        return value;
-    }
 
-    /*!
-     * \brief concatenates adjacent strings
-     * \param tokens
-     * \return tokens with concatenated strings
-     */
-    token_array _concat_string(const token_array& tokens)
-    {
-        BOOST_ASSERT(!tokens.empty());
+        operator int () const
+        {
+            long t = _integer();
+            if(t > std::numeric_limits<int>::max() || t < std::numeric_limits<int>::min()) {
+                throw _type_ex("type overflow");
+            }
+            return t;
+        }
 
-        token_array result;
-        result.push_back(tokens.front());
-        for(size_t i=1; i<tokens.size(); i++) {
-            token& prev = result.back();
-            const token& cur = tokens[i];
-            if (prev[0] == '"' && cur[0] == '"') {
-                prev = prev.substr(0, prev.size() - 1);
-                prev += cur.substr(1);
-            } else {
-                result.push_back(cur);
+        operator unsigned () const
+        {
+            long t = _integer();
+            if(t < 0) {
+                throw _type_ex("negative value");
+            } else if (static_cast<unsigned long>(t) > std::numeric_limits<unsigned int>::max()) {
+                throw _type_ex("type overflow");
             }
+            return t;
         }
-        return result;
-    }
 
-    _basic_setting _read_file(const string_type& path, const string_type& include_dir =
-            boost::filesystem::current_path().generic_string())
-    {
-        using namespace boost::filesystem;
-        _basic_setting root("");
-        string_type _path = _construct_path(path, include_dir);
+        operator long () const
+        {
+            return _integer();
+        }
 
-        parser p(string_ptr(new string_type(_path)), include_dir, 0);
-        token_array tokens = p.parse();
-        if (!tokens.empty()) {
-            tokens = _concat_string(tokens);
-            token_iterator begin = tokens.begin();
-            token_iterator end = tokens.end();
-            _basic_setting_array settings = _get_setting_list(begin, end);
-            for (size_t i = 0; i < settings.size(); i++) {
-                root.add(settings[i]);
+        operator unsigned long () const
+        {
+            long t = _integer();
+            if (t < 0) {
+                throw _type_ex("negative value");
             }
+            return t;
         }
-        return root;
-    }
 
-    _basic_setting_array _get_setting_list(token_iterator& begin, token_iterator& end)
-    {
-        _basic_setting_array settings;
-        while(begin != end) {
-            token tok = *begin++;
-            if(tok == "[" || tok == "]") {
-                throw _syntax_exception("unexpected array", tok);
-            } else if(tok == "{" || tok == "}") {
-                throw _syntax_exception("unexpected group setting without identifier", tok);
-            } else if(tok == "," || tok == "=" || tok == ":") {
-                throw _syntax_exception("unexpected token " + tok, tok);
-            } else {
-                settings.push_back(_get_setting(tok, begin, end));
+        operator float () const
+        {
+            if (getType() == setting_type::TypeFloat) {
+                return _payload().floating;
             }
+            return _integer();
         }
-        return settings;
-    }
 
-    _basic_setting _get_setting(const token& identifier, token_iterator& begin, token_iterator& end)
-    {
-        if (begin != end) {
-            token tok = *begin++;
-            if (tok == "=" || tok == ":") {
-                if (begin != end) {
-                    tok = *begin;
-                    if (tok == "{") {
-                        _basic_setting result = _get_group(identifier, begin, end);
-                        begin = _skip_end(begin, end);
-                        return result;
-                    } else if (tok == "(") {
-                        _basic_setting result = _get_list(identifier, begin, end);
-                        begin = _skip_end(begin, end);
-                        return result;
-                    } else if (tok == "[") {
-                        _basic_setting result = _get_array(identifier, begin, end);
-                        begin = _skip_end(begin, end);
-                        return result;
-                    } else {
-                        _basic_setting result = _get_scalar_item(identifier, *begin++);
-                        begin = _skip_end(begin, end);
-                        return result;
-                    }
-                } else {
-                    throw _syntax_exception("unexpected end of file", tok, true);
-                }
-            } else {
-                throw _syntax_exception("unexpected token " + tok, tok);
-            }
-        } else {
-            throw _syntax_exception("unexpected end of file", identifier, true);
+        operator double () const
+        {
+            return static_cast<float>(*this);
         }
-    }
 
-    _basic_setting _get_group(const token& identifier, token_iterator& begin, token_iterator& end)
-    {
-        token_iterator _begin = begin;
-        token_iterator _end = _find_pair("{", "}", _begin++, end);
+        operator string_type () const
+        {
+            return getString();
+        }
 
-        begin = _end;
-        if (begin != end) {
-            ++begin;
+        const string_type& getString() const
+        {
+            if (getType() != setting_type::TypeString) {
+                throw _type_ex("unsupported conversion");
+            }
+            return m_table->m_strings[_payload().string];
         }
 
-        _basic_setting result(static_cast<string_type>(identifier));
-        _basic_setting_array settings = _get_setting_list(_begin, _end);
+        const char_type* c_str() const
+        {
+            return getString().c_str();
+        }
 
-        for(size_t i=0; i<settings.size(); i++) {
-            result.add(settings[i]);
+    private:
+        const typename basic_setting_table::payload& _payload() const
+        {
+            return m_table->m_values[m_node];
         }
-        return result;
-    }
 
-    _basic_setting _get_list(const token& identifier, token_iterator& begin, token_iterator& end)
-    {
-        token_iterator _begin = begin;
-        token_iterator _end = _find_pair("(", ")", _begin, end);
+        long _integer() const
+        {
+            switch (getType()) {
+            case setting_type::TypeBoolean:
+            case setting_type::TypeInt:
+            case setting_type::TypeInt64:
+                return _payload().integer;
+            default:
+                throw _type_ex("unsupported conversion");
+            }
+        }
 
-        begin = _end;
-        if(begin != end) {
-            ++begin;
+        SettingTypeException _type_ex(const string_type& msg) const
+        {
+            return SettingTypeException(msg, getPath());
+        }
+
+        /*!
+         * \brief returns the exception for path, which is relative to this node
+         */
+        SettingNotFoundException _not_found_ex(const string_type& path) const
+        {
+            string_type full = getPath();
+            if (!full.empty()) {
+                full += '.';
+            }
+            return SettingNotFoundException("Setting not found", full + path);
         }
 
-        _basic_setting list(string_type(identifier), value_type::TypeList);
+        const basic_setting_table* m_table;
+        node_id m_node;
+    };
 
-        token_iterator _last = _begin;
-        while(_begin != _end) {
-            _last = ++_begin;
-            _begin = _find_list_item(_begin, _end);
-            if(_last != _begin)
-                list.add(_get_list_item(_last, _begin));
-        };
+    friend class view;
+
+    /*!
+     * \brief copies root and everything below it into a new table
+     *
+     * Deferred parts of the tree are parsed while copying.
+     */
+    explicit basic_setting_table(const setting_type& root)
+    {
+        _append(root, npos);
+    }
 
-        return list;
+    view getRoot() const
+    {
+        return view(*this, 0);
     }
 
-    _basic_setting _get_array(const token& identifier, token_iterator& begin, token_iterator& end)
+    view operator[](node_id node) const
     {
-        token_iterator _begin = begin;
-        token_iterator _end = _find_pair("[", "]", _begin, end);
+        BOOST_ASSERT(node < size());
+        return view(*this, node);
+    }
 
-        begin = _end;
-        if(begin != end) {
-            ++begin;
-        }
+    /*!
+     * \brief number of nodes, the root included
+     */
+    size_t size() const
+    {
+        return m_types.size();
+    }
 
-        _basic_setting array(identifier, value_type::TypeArray);
+private:
+    typedef boost::unordered_map<string_type, size_t> name_map;
+    typedef std::pair<node_id, size_t> member_key;
+    typedef boost::unordered_map<member_key, node_id> member_map;
 
-        token_iterator _last = begin;
-        while(_begin != _end) {
-            _last = ++_begin;
-            _begin = _find_list_item(_begin, _end);
-            if (_last != _begin)
-                array.add(_get_list_item(_last, _begin));
-        };
+    union payload
+    {
+        long integer;           //!< value of booleans and integers
+        float floating;         //!< value of floats
+        size_t string;          //!< index into m_strings
+    };
 
-        return array;
+    node_id _append(const setting_type& setting, node_id parent)
+    {
+        node_id node = m_types.size();
+        size_t length = setting.getLength();
+
+        m_types.push_back(setting.getType());
+        m_formats.push_back(setting.getFormat());
+        m_names.push_back(_name_id(setting.getName()));
+        m_parents.push_back(parent);
+        m_child_begin.push_back(m_child_ids.size());
+        m_child_count.push_back(length);
+        m_values.push_back(_payload(setting));
+
+        // reserve the child range first, subtrees append behind it
+        size_t begin = m_child_ids.size();
+        m_child_ids.resize(begin + length);
+        if (setting.isArray()) {
+            _append_elements(setting, node, begin);
+            return node;
+        }
+        for (size_t i = 0; i < length; i++) {
+            // _append grows m_child_ids, so take the id before indexing
+            node_id child = _append(setting[static_cast<int>(i)], node);
+            m_child_ids[begin + i] = child;
+            if (setting.isGroup()) {
+                m_members.insert(std::make_pair(member_key(node, m_names[child]), child));
+            }
+        }
+        return node;
     }
 
-    _basic_setting _get_list_item(token_iterator begin, token_iterator end)
+    /*!
+     * \brief appends the elements of an array straight from its packed storage
+     */
+    void _append_elements(const setting_type& array, node_id parent, size_t begin)
     {
-        BOOST_ASSERT(begin != end);
-        token tok = *begin;
-        if(tok == "(") {
-            return _get_list("", begin, end);
-        } else if (tok == "{") {
-            return _get_group("", begin, end);
-        } else if (tok == "[") {
-            return _get_array("", begin, end);
-        } else {
-            return _get_scalar_item("", tok);
+        const typename setting_type::_packed_array& packed = array.m_children->packed;
+        typename setting_type::_scalar_value value(packed.element);
+        size_t name = _name_id(string_type());
+        for (size_t i = 0; i < packed.size(); i++) {
+            packed.load(i, value);
+            m_child_ids[begin + i] = m_types.size();
+            m_types.push_back(packed.element);
+            m_formats.push_back(packed.format(i));
+            m_names.push_back(name);
+            m_parents.push_back(parent);
+            m_child_begin.push_back(m_child_ids.size());
+            m_child_count.push_back(0);
+            m_values.push_back(_payload(value));
         }
     }
 
-    config_type _get_scalar_type(const token& value)
+    payload _payload(const setting_type& setting)
     {
-        using namespace std;
-        using namespace boost;
-
-        regex rx_boolean("^([Tt][Rr][Uu][Ee])|([Ff][Aa][Ll][Ss][Ee])$");
-        regex rx_int("^[-+]?[0-9]+$");
-        regex rx_int64("^[-+]?[0-9]+L(L)?$");
-        regex rx_hex("^0[Xx][0-9A-Fa-f]+$");
-        regex rx_hex64("^0[Xx][0-9A-Fa-f]+L(L)?$");
-        regex rx_float("^([-+]?([0-9]*)?\\.[0-9]*([eE][-+]?[0-9]+)?)|"
-                       "([-+]?([0-9]+)(\\.[0-9]*)?[eE][-+]?[0-9]+)$");
-
-        if (value[0] == '"') {
-            return value_type::TypeString;
-        } else if (regex_match(value, rx_boolean)) {
-            return value_type::TypeBoolean;
-        } else if (regex_match(value, rx_int)) {
-            return value_type::TypeInt;
-        } else if (regex_match(value, rx_hex)) {
-            return value_type::TypeInt;
-        } else if (regex_match(value, rx_int64)) {
-            return value_type::TypeInt64;
-        } else if (regex_match(value, rx_hex64)) {
-            return value_type::TypeInt64;
-        } else if (regex_match(value, rx_float)) {
-            return value_type::TypeFloat;
-        } else {
-            return value_type::TypeGroup;
+        if (setting.isAggredate()) {
+            payload value;
+            value.integer = 0;
+            return value;
         }
+        return _payload(setting.m_scalar);
     }
 
-    _basic_setting _get_scalar_item(const token& name, const token& value)
+    payload _payload(const typename setting_type::_scalar_value& scalar)
     {
-        using namespace std;
-        using namespace boost;
-
-        regex rx_hex("^0[Xx][0-9A-Fa-f]+$");
-        regex rx_hex64("^0[Xx][0-9A-Fa-f]+L(L)?$");
-
-        typename value_type::Type type = _get_scalar_type(value);
-        _basic_setting setting(name, type);
-        istringstream iss(value);
-
-        switch(type)
-        {
-        case value_type::TypeString:
-            setting = _remove_quotes(value);
-            break;
-        case value_type::TypeBoolean:
-        {
-            bool v;
-            iss >> v;
-            setting = v;
+        payload value;
+        value.integer = 0;
+        switch (scalar.type()) {
+        case setting_type::TypeBoolean:
+            value.integer = scalar.boolean() ? 1 : 0;
             break;
-        }
-        case value_type::TypeInt:
-        {
-            int v;
-            if (regex_match(value, rx_hex)) {
-                setting.setFormat(value_type::FormatHex);
-                iss >> hex;
-            }
-            iss >> v;
-            setting = v;
+        case setting_type::TypeInt:
+            value.integer = scalar.integer();
             break;
-        }
-        case value_type::TypeInt64:
-        {
-            long v;
-            if (regex_match(value, rx_hex64)) {
-                setting.setFormat(value_type::FormatHex);
-                iss >> hex;
-            }
-            iss >> v;
-            setting = v;
+        case setting_type::TypeInt64:
+            value.integer = scalar.integer64();
             break;
-        }
-        case value_type::TypeFloat:
-        {
-            float v;
-            iss >> v;
-            setting = v;
+        case setting_type::TypeFloat:
+            value.floating = scalar.floating();
             break;
-        }
         default:
-            throw _syntax_exception("invalid value " + value, value);
+            value.string = m_strings.size();
+            m_strings.push_back(scalar.string());
         }
-        return setting;
+        return value;
     }
 
-    token_iterator _skip_end(token_iterator& begin, token_iterator& end)
+    size_t _name_id(const string_type& name)
     {
-        if (begin != end && (*begin == ";" || *begin == ",")) {
-            return ++begin;
+        typename name_map::iterator it = m_name_ids.find(name);
+        if (it != m_name_ids.end()) {
+            return it->second;
         }
-        return begin;
+        m_name_pool.push_back(name);
+        m_name_ids.insert(std::make_pair(name, m_name_pool.size() - 1));
+        return m_name_pool.size() - 1;
     }
 
-    token_iterator _find_pair(const string_type& open_token, const string_type& close_token,
-                              token_iterator begin, token_iterator end)
+    const node_id* _children(node_id node) const
     {
-        token_iterator _it(begin);
-        size_t count = 0;
-        while(_it != end) {
-            token tok = *_it;
-            if (tok == open_token) {
-                count++;
-            } else if(tok == close_token) {
-                if (count == 1) {
-                    return _it;
-                } else {
-                    count--;
-                }
-            }
-            ++_it;
+        if (m_child_ids.empty()) {
+            return 0;
         }
-        throw _syntax_exception("unable to find closing tag of " + *begin, *begin);
+        return &m_child_ids[0] + m_child_begin[node];
     }
 
-    token_iterator _find_list_item(token_iterator begin, token_iterator end)
+    node_id _find(node_id node, size_t index) const
     {
-        token_iterator _it(begin);
-        size_t a_brace = 0;
-        size_t g_brace = 0;
-        size_t l_brace = 0;
-
-        while(_it != end) {
-            token tok = *_it;
-            if (tok == "[") {
-                a_brace++;
-            } else if (tok == "]") {
-                if (a_brace == 0)
-                    throw _syntax_exception("unmatched array brace", tok);
-                a_brace--;
-            } else if (tok == "{") {
-                g_brace++;
-            } else if (tok == "}") {
-                if (g_brace == 0)
-                    throw _syntax_exception("unmatched group brace", tok);
-                g_brace--;
-            } else if (tok == "(") {
-                l_brace++;
-            } else if (tok == ")") {
-                if (l_brace == 0)
-                    throw _syntax_exception("unmatched list brace", tok);
-                l_brace--;
-            } else if (tok == "," && !a_brace && !g_brace && !l_brace) {
-                return _it;
-            }
-            ++_it;
+        if (index >= m_child_count[node]) {
+            return npos;
         }
-
-        return end;
+        return _children(node)[index];
     }
 
-    static ParseException _syntax_exception(const string_type& msg, const token& tok,
-                                            bool offset_at_end_of_token = false)
+    /*!
+     * \brief finds a member of a group by its name id and the group
+     */
+    node_id _find(node_id node, const string_type& name) const
     {
-        std::ostringstream ss;
-        size_t offset = tok.offset;
-        if (offset_at_end_of_token)
-            offset += tok.size();
-
-        string_type file;
-        if (tok.file) {
-            file = *tok.file;
+        typename name_map::const_iterator it = m_name_ids.find(name);
+        if (it == m_name_ids.end()) {
+            return npos;
         }
+        typename member_map::const_iterator member = m_members.find(member_key(node, it->second));
+        return member != m_members.end() ? member->second : npos;
+    }
 
-        return ParseException(ss.str(), file, tok.line, tok.offset);
+    /*!
+     * \brief parses a path component of the form [n]
+     * \return false if the component is not an index, index is npos if
+     * it does not fit
+     */
+    static bool _parse_index(const string_type& path, size_t begin, size_t end, size_t* index)
+    {
+        if (end - begin < 3 || path[begin] != '[' || path[end - 1] != ']') {
+            return false;
+        }
+        size_t value = 0;
+        for (size_t i = begin + 1; i < end - 1; i++) {
+            if (path[i] < '0' || path[i] > '9') {
+                return false;
+            }
+            size_t digit = path[i] - '0';
+            if (value != npos) {
+                value = value > (npos - digit) / 10 ? npos : value * 10 + digit;
+            }
+        }
+        *index = value;
+        return true;
     }
 
-    static ParseException _syntax_exception(const ParseException& ex, const string_type* file)
+    node_id _lookup(node_id node, const string_type& path) const
     {
-        return ParseException(ex.what(), *file, ex.line(), ex.offset());
+        size_t begin = 0;
+        while (node != npos && begin <= path.size()) {
+            size_t end = path.find('.', begin);
+            if (end == string_type::npos) {
+                end = path.size();
+            }
+            size_t index;
+            if (_parse_index(path, begin, end, &index)) {
+                node = _find(node, index);
+            } else {
+                node = _find(node, path.substr(begin, end - begin));
+            }
+            begin = end + 1;
+        }
+        return node;
     }
+
+    std::vector<Type> m_types;
+    std::vector<Format> m_formats;
+    std::vector<size_t> m_names;
+    std::vector<node_id> m_parents;
+    std::vector<size_t> m_child_begin;
+    std::vector<size_t> m_child_count;
+    std::vector<payload> m_values;
+    std::vector<node_id> m_child_ids;
+    std::vector<string_type> m_strings;
+    std::vector<string_type> m_name_pool;
+    name_map m_name_ids;
+    member_map m_members;       //!< members of every group by group and name id
 };
 
+template<typename charT>
+const typename basic_setting_table<charT>::node_id basic_setting_table<charT>::npos;
+
 template<typename CharT>
 std::ostream& operator<<(std::ostream &o, const basic_setting<CharT>& rhs)
 {
@@ -2429,6 +6237,10 @@ std::ostream& operator<<(std::ostream &o, const basic_setting<CharT>& rhs)
 
 typedef basic_setting<char> Setting;
 typedef basic_config<char> Config;
+typedef basic_config_writer<char> ConfigWriter;
+typedef basic_setting_table<char> SettingTable;
+typedef basic_setting_ref<char> SettingRef;
+typedef basic_atom_table<char> AtomTable;
 
 }
 
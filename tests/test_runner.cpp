@@ -23,6 +23,7 @@
 #define BOOST_TEST_MODULE Hello
 #include <boost/test/unit_test.hpp>
 #include <libconfigpp.h>
+#include <clocale>
 
 BOOST_AUTO_TEST_CASE(read_simple_config)
 {
@@ -36,3 +37,1133 @@ BOOST_AUTO_TEST_CASE(read_simple_config)
     BOOST_CHECK_EQUAL(string_value,"string");
 }
 
+
+BOOST_AUTO_TEST_CASE(lazy_parse_matches_eager_parse)
+{
+    libconfig::Config eager("nested_config.cfg");
+    libconfig::Config lazy;
+    lazy.setOption(libconfig::Config::OptionLazyParse, true);
+    lazy.readFile("nested_config.cfg");
+
+    int port = lazy["server.port"];
+    std::string path = lazy["handlers.[1].path"];
+    BOOST_CHECK_EQUAL(port, 8080);
+    BOOST_CHECK_EQUAL(path, "/api");
+    BOOST_CHECK_EQUAL(lazy["server.ports"].getLength(), 3u);
+
+    std::ostringstream eager_out, lazy_out;
+    eager_out << eager;
+    lazy_out << lazy;
+    BOOST_CHECK_EQUAL(eager_out.str(), lazy_out.str());
+}
+
+BOOST_AUTO_TEST_CASE(parallel_parse_matches_serial_parse)
+{
+    boost::filesystem::path path = boost::filesystem::temp_directory_path() /
+            boost::filesystem::unique_path("libconfigpp-%%%%-%%%%.cfg");
+    {
+        std::ofstream out(path.c_str());
+        for (int i = 0; i < 3000; i++) {
+            out << "key" << i << " = " << i << ";\n";
+        }
+        out << "items = (";
+        for (int i = 0; i < 3000; i++) {
+            out << (i ? ", " : "") << "{ value = " << i << "; }";
+        }
+        out << ");\n";
+    }
+
+    libconfig::Config serial(path.string());
+    libconfig::Config parallel;
+    parallel.setOption(libconfig::Config::OptionParallelParse, true);
+    parallel.setParseThreads(4);
+    parallel.readFile(path.string());
+
+    int value = parallel["items.[2999].value"];
+    BOOST_CHECK_EQUAL(value, 2999);
+
+    std::ostringstream serial_out, parallel_out;
+    serial_out << serial;
+    parallel_out << parallel;
+    BOOST_CHECK(serial_out.str() == parallel_out.str());
+
+    {
+        std::ofstream out(path.c_str());
+        for (int i = 0; i < 3000; i++) {
+            out << "key" << i << " = " << (i == 2000 || i == 2500 ? "x" : "1") << ";\n";
+        }
+    }
+    try {
+        parallel.readFile(path.string());
+        BOOST_ERROR("ParseException expected");
+    } catch (libconfig::ParseException& ex) {
+        BOOST_CHECK_EQUAL(ex.line(), 2001u);
+    }
+
+    // a repeated name in front of a parse error is reported first
+    {
+        std::ofstream out(path.c_str());
+        for (int i = 0; i < 6000; i++) {
+            if (i == 4000) {
+                out << "key5 = 1;\n";
+            } else if (i == 5900) {
+                out << "bad = x;\n";
+            } else {
+                out << "key" << i << " = 1;\n";
+            }
+        }
+    }
+    BOOST_CHECK_THROW(serial.readFile(path.string()), libconfig::SettingNameException);
+    BOOST_CHECK_THROW(parallel.readFile(path.string()), libconfig::SettingNameException);
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(read_string)
+{
+    libconfig::Config cfg;
+    cfg.readString("int = 1; group = { string = \"string\"; };");
+
+    int int_value = cfg["int"];
+    std::string string_value = cfg["group.string"];
+    BOOST_CHECK_EQUAL(int_value, 1);
+    BOOST_CHECK_EQUAL(string_value, "string");
+}
+
+BOOST_AUTO_TEST_CASE(parse_limits)
+{
+    const std::string text = "a = 1; b = { c = (1, [2, 3], { d = \"four\"; }); };";
+    libconfig::Config cfg;
+
+    libconfig::ParseLimits limits;
+    limits.maxNodes = 9;
+    limits.maxDepth = 3;
+    limits.maxStringLength = 4;
+    limits.maxBytes = text.size();
+    cfg.readString(text, limits);
+    BOOST_CHECK_EQUAL(cfg.getLength(), 2u);
+
+    libconfig::ParseLimits nodes;
+    nodes.maxNodes = 8;
+    BOOST_CHECK_THROW(cfg.readString(text, nodes), libconfig::ParseException);
+
+    libconfig::ParseLimits depth;
+    depth.maxDepth = 2;
+    BOOST_CHECK_THROW(cfg.readString(text, depth), libconfig::ParseException);
+
+    libconfig::ParseLimits length;
+    length.maxStringLength = 3;
+    BOOST_CHECK_THROW(cfg.readString(text, length), libconfig::ParseException);
+
+    libconfig::ParseLimits bytes;
+    bytes.maxBytes = text.size() - 1;
+    BOOST_CHECK_THROW(cfg.readString(text, bytes), libconfig::ParseException);
+
+    libconfig::ParseLimits includes;
+    includes.maxIncludes = 1;
+    BOOST_CHECK_THROW(cfg.readString("@include \"simple_config.cfg\"\n"
+                                     "@include \"nested_config.cfg\"\n", includes),
+                      libconfig::ParseException);
+
+    BOOST_CHECK_EQUAL(cfg.getLength(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(config_writer_matches_print)
+{
+    libconfig::Config cfg;
+    cfg.add("enabled", libconfig::Setting::TypeBoolean) = true;
+    libconfig::Setting& server = cfg.add("server", libconfig::Setting::TypeGroup);
+    server.add("host", libconfig::Setting::TypeString) = std::string("localhost");
+    libconfig::Setting& mask = server.add("mask", libconfig::Setting::TypeInt);
+    mask = 0xff;
+    mask.setFormat(libconfig::Setting::FormatHex);
+    libconfig::Setting& ports = server.add("ports", libconfig::Setting::TypeArray);
+    ports.add(libconfig::Setting::TypeInt64) = 80L;
+    ports.add(libconfig::Setting::TypeInt64) = 443L;
+    libconfig::Setting& list = cfg.add("list", libconfig::Setting::TypeList);
+    list.add(libconfig::Setting::TypeFloat) = 2.5f;
+    list.add(libconfig::Setting::TypeGroup).add("name", libconfig::Setting::TypeString) =
+            std::string("item");
+    list.add(libconfig::Setting::TypeList);
+
+    std::ostringstream printed, written;
+    printed << cfg;
+
+    libconfig::ConfigWriter writer(written);
+    writer.scalar("enabled", true)
+          .beginGroup("server")
+              .scalar("host", "localhost")
+              .scalar("mask", 0xff, libconfig::Setting::FormatHex)
+              .beginArray("ports").scalar("", 80L).scalar("", 443L).endArray()
+          .endGroup()
+          .beginList("list")
+              .scalar("", 2.5)
+              .beginGroup().scalar("name", "item").endGroup()
+              .beginList().endList()
+          .endList();
+    writer.finish();
+
+    BOOST_CHECK_EQUAL(printed.str(), written.str());
+    BOOST_CHECK_THROW(writer.endGroup(), libconfig::ConfigException);
+}
+
+BOOST_AUTO_TEST_CASE(config_writer_checks_names)
+{
+    std::ostringstream written;
+    libconfig::ConfigWriter writer(written);
+    writer.scalar("port", 80).beginGroup("server").scalar("port", 81);
+    BOOST_CHECK_THROW(writer.scalar("port", 82), libconfig::SettingNameException);
+    BOOST_CHECK_THROW(writer.beginList("port"), libconfig::SettingNameException);
+    BOOST_CHECK_THROW(writer.scalar("a.b", 1), libconfig::SettingNameException);
+    BOOST_CHECK_THROW(writer.scalar("a b", 1), libconfig::SettingNameException);
+    BOOST_CHECK_THROW(writer.scalar("a=b", 1), libconfig::SettingNameException);
+    writer.endGroup();
+    BOOST_CHECK_THROW(writer.scalar("port", 83), libconfig::SettingNameException);
+    writer.beginList("list").beginGroup().scalar("port", 1).endGroup()
+          .beginGroup().scalar("port", 2).endGroup().endList();
+    writer.finish();
+
+    libconfig::Config cfg;
+    cfg.readString(written.str());
+    BOOST_CHECK_EQUAL(static_cast<int>(cfg["port"]), 80);
+    BOOST_CHECK_EQUAL(static_cast<int>(cfg["server.port"]), 81);
+    BOOST_CHECK_EQUAL(static_cast<int>(cfg["list.[1].port"]), 2);
+}
+
+#ifdef LIBCONFIGPP_HAS_FUTURES
+struct deferred_executor
+{
+    explicit deferred_executor(std::vector<boost::function<void ()> >& tasks)
+        : m_tasks(tasks)
+    {}
+
+    void operator()(const boost::function<void ()>& task)
+    {
+        m_tasks.push_back(task);
+    }
+
+    std::vector<boost::function<void ()> >& m_tasks;
+};
+
+BOOST_AUTO_TEST_CASE(load_async)
+{
+    libconfig::Config settings;
+    settings.setOption(libconfig::Config::OptionLazyParse, true);
+
+    libconfig::Config::config_ptr cfg = settings.loadAsync("nested_config.cfg").get();
+    int port = (*cfg)["server.port"];
+    BOOST_CHECK_EQUAL(port, 8080);
+    BOOST_CHECK(cfg->getOption(libconfig::Config::OptionLazyParse));
+
+    std::vector<boost::function<void ()> > tasks;
+    std::future<libconfig::Config::config_ptr> pending =
+            settings.loadAsync("simple_config.cfg", deferred_executor(tasks));
+    BOOST_REQUIRE_EQUAL(tasks.size(), 1u);
+    tasks.front()();
+    int int_value = (*pending.get())["int"];
+    BOOST_CHECK_EQUAL(int_value, 1);
+
+    libconfig::ParseLimits limits;
+    limits.maxBytes = 1;
+    BOOST_CHECK_THROW(settings.loadAsync("simple_config.cfg", limits).get(),
+                      libconfig::ParseException);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(setting_table_matches_tree)
+{
+    libconfig::Config cfg("nested_config.cfg");
+    libconfig::SettingTable table(cfg);
+    libconfig::SettingTable::view root = table.getRoot();
+
+    BOOST_CHECK_EQUAL(table.size(), 22u);
+    BOOST_CHECK(root.isRoot());
+    BOOST_CHECK_EQUAL(root.getLength(), cfg.getLength());
+
+    int port = root["server.port"];
+    long retries = root["server.limits.retries"];
+    float timeout = root.lookup("server.limits.timeout");
+    std::string path = root["handlers.[1].path"];
+    BOOST_CHECK_EQUAL(port, 8080);
+    BOOST_CHECK_EQUAL(retries, 3L);
+    BOOST_CHECK_CLOSE(timeout, 2.5f, 0.001);
+    BOOST_CHECK_EQUAL(path, "/api");
+    BOOST_CHECK_EQUAL(root["server.ports"][2].getIndex(), 2);
+    BOOST_CHECK_EQUAL(root["server.limits"].getPath(), cfg["server.limits"].getPath());
+    BOOST_CHECK_EQUAL(root["handlers.[2]"].getFormat(), libconfig::Setting::FormatDefault);
+    BOOST_CHECK_EQUAL(root["handlers.[2]"][0].getFormat(), libconfig::Setting::FormatHex);
+
+    BOOST_CHECK(root.exists("server.limits.timeout"));
+    BOOST_CHECK(!root.exists("server.limits.missing"));
+    BOOST_CHECK_THROW(root["server.missing"], libconfig::SettingNotFoundException);
+    BOOST_CHECK_THROW(static_cast<int>(root["name"]), libconfig::SettingTypeException);
+
+    std::string name;
+    BOOST_CHECK(root.lookupValue("name", name));
+    BOOST_CHECK_EQUAL(name, "nested");
+    BOOST_CHECK(!root.lookupValue("server.host", port));
+}
+
+BOOST_AUTO_TEST_CASE(setting_table_lookups)
+{
+    std::ostringstream text;
+    text << "wide = {";
+    for (int i = 0; i < 500; i++) {
+        text << " m" << i << " = " << i << ";";
+    }
+    text << " };\nlist = ( { m7 = \"x\"; } );\n";
+    libconfig::Config cfg;
+    cfg.readString(text.str());
+    libconfig::SettingTable table(cfg);
+    libconfig::SettingTable::view root = table.getRoot();
+
+    BOOST_CHECK_EQUAL(static_cast<int>(root["wide.m0"]), 0);
+    BOOST_CHECK_EQUAL(static_cast<int>(root["wide.m499"]), 499);
+    BOOST_CHECK_EQUAL(root["list.[0].m7"].getString(), "x");
+    BOOST_CHECK_EQUAL(root["list.[00].m7"].getPath(), "list..m7");
+    BOOST_CHECK(!root.exists("wide.m7.m7"));
+    BOOST_CHECK(!root.exists("list.m7"));
+    BOOST_CHECK(!root.exists("list.[1]"));
+    BOOST_CHECK(!root.exists("list.[]"));
+    BOOST_CHECK(!root.exists("list.[0x0]"));
+    BOOST_CHECK(!root.exists("list.[99999999999999999999999]"));
+
+    try {
+        root["wide"].lookup("missing");
+        BOOST_ERROR("lookup of a missing member succeeded");
+    } catch (const libconfig::SettingNotFoundException& ex) {
+        BOOST_CHECK_EQUAL(ex.path(), "wide.missing");
+    }
+    try {
+        static_cast<void>(root["list.[0].m7"].operator int());
+        BOOST_ERROR("a string converted to int");
+    } catch (const libconfig::SettingTypeException& ex) {
+        BOOST_CHECK_EQUAL(ex.path(), "list..m7");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(interned_names)
+{
+    libconfig::AtomTable atoms;
+    BOOST_CHECK_EQUAL(atoms.find(""), 0u);
+    BOOST_CHECK_EQUAL(atoms.find("host"), libconfig::AtomTable::npos);
+
+    std::vector<libconfig::AtomTable::atom_type> ids;
+    for (int i = 0; i < 300; i++) {
+        std::ostringstream name;
+        name << "name" << i;
+        ids.push_back(atoms.intern(name.str()));
+    }
+    BOOST_CHECK_EQUAL(atoms.intern("name7"), ids[7]);
+    BOOST_CHECK_EQUAL(atoms.name(ids[299]), "name299");
+    BOOST_CHECK_EQUAL(atoms.find("name250"), ids[250]);
+
+    libconfig::Config* original = new libconfig::Config("nested_config.cfg");
+    libconfig::Config copy(*original);
+    delete original;
+    BOOST_CHECK_EQUAL(copy["server.limits"].getPath(), "server.limits");
+    BOOST_CHECK_EQUAL(copy["handlers.[0]"].getLength(), 2u);
+    copy["server"].remove("port");
+    BOOST_CHECK(!copy.exists("server.port"));
+}
+
+BOOST_AUTO_TEST_CASE(groups_keep_insertion_order)
+{
+    libconfig::Config cfg;
+    libconfig::Setting& group = cfg.add("group", libconfig::Setting::TypeGroup);
+    for (int i = 0; i < 100; i++) {
+        std::ostringstream name;
+        name << "m" << (99 - i);
+        group.add(name.str(), libconfig::Setting::TypeInt) = i;
+    }
+
+    BOOST_CHECK_EQUAL(group[0].getName(), "m99");
+    BOOST_CHECK_EQUAL(group[99].getName(), "m0");
+    BOOST_CHECK_EQUAL(group["m42"].getIndex(), 57);
+    int value = group["m10"];
+    BOOST_CHECK_EQUAL(value, 89);
+    BOOST_CHECK_THROW(group.add("m5", libconfig::Setting::TypeInt), libconfig::SettingNameException);
+
+    group.remove("m99");
+    group.remove(static_cast<size_t>(0));
+    BOOST_CHECK_EQUAL(group.getLength(), 98u);
+    BOOST_CHECK(!group.exists("m98"));
+    BOOST_CHECK_EQUAL(group[0].getName(), "m97");
+    BOOST_CHECK_EQUAL(group["m0"].getIndex(), 97);
+
+    libconfig::Config parsed;
+    parsed.readString("b = 1; a = { y = 2; x = 3; };");
+    std::ostringstream printed;
+    printed << parsed;
+    BOOST_CHECK_EQUAL(printed.str(), "b = 1;\na = {\n    y = 2;\n    x = 3;\n};\n");
+}
+
+BOOST_AUTO_TEST_CASE(scalar_conversions)
+{
+    libconfig::Config cfg;
+    libconfig::Setting& flag = cfg.add("flag", libconfig::Setting::TypeInt);
+    flag = false;
+    BOOST_CHECK_EQUAL(static_cast<int>(flag), 0);
+    flag = true;
+    BOOST_CHECK(static_cast<bool>(flag));
+
+    libconfig::Setting& big = cfg.add("big", libconfig::Setting::TypeInt64);
+    big = 1L << 40;
+    BOOST_CHECK_EQUAL(static_cast<long>(big), 1L << 40);
+    BOOST_CHECK_THROW(static_cast<int>(big), libconfig::SettingTypeException);
+
+    libconfig::Setting& ratio = cfg.add("ratio", libconfig::Setting::TypeFloat);
+    ratio = 3;
+    BOOST_CHECK_CLOSE(static_cast<double>(ratio), 3.0, 0.001);
+
+    libconfig::Setting& text = cfg.add("text", libconfig::Setting::TypeString);
+    text = std::string("a string longer than the small string buffer");
+    libconfig::Config copy(cfg);
+    BOOST_CHECK_EQUAL(static_cast<std::string>(copy["text"]),
+                      "a string longer than the small string buffer");
+    BOOST_CHECK_THROW(static_cast<int>(text), libconfig::SettingTypeException);
+}
+
+BOOST_AUTO_TEST_CASE(packed_arrays)
+{
+    libconfig::Config cfg;
+    cfg.readString("values = [1, 2, 3, 4]; masks = [0x10, 2];");
+    libconfig::Setting& values = cfg["values"];
+    BOOST_CHECK_EQUAL(values.getLength(), 4u);
+
+    libconfig::Setting& third = values[2];
+    BOOST_CHECK_EQUAL(&third, &values[2]);
+    BOOST_CHECK_EQUAL(third.getIndex(), 2);
+    third = 30;
+    values.remove(static_cast<size_t>(0));
+    BOOST_CHECK_EQUAL(third.getIndex(), 1);
+    BOOST_CHECK_EQUAL(static_cast<int>(values[1]), 30);
+
+    values.add(libconfig::Setting::TypeInt) = 5;
+    BOOST_CHECK_THROW(values.add(libconfig::Setting::TypeFloat), libconfig::SettingTypeException);
+    BOOST_CHECK_THROW(values.add(libconfig::Setting::TypeList), libconfig::SettingTypeException);
+
+    std::ostringstream printed;
+    printed << cfg;
+    BOOST_CHECK_EQUAL(printed.str(), "values = [2, 30, 4, 5];\nmasks = [0x10, 2];\n");
+
+    libconfig::Config copy(cfg);
+    BOOST_CHECK(copy["values"] == values);
+    copy["values"][3] = 6;
+    BOOST_CHECK(!(copy["values"] == values));
+
+    libconfig::SettingTable table(cfg);
+    int last = table.getRoot()["values.[3]"];
+    BOOST_CHECK_EQUAL(last, 5);
+    BOOST_CHECK_EQUAL(table.getRoot()["masks"][0].getFormat(), libconfig::Setting::FormatHex);
+}
+
+BOOST_AUTO_TEST_CASE(index_of_equal_siblings)
+{
+    libconfig::Config cfg;
+    cfg.readString("list = ({ a = 1; }, { a = 1; }, { a = 1; });");
+    libconfig::Setting& list = cfg["list"];
+    BOOST_CHECK_EQUAL(list[0].getIndex(), 0);
+    BOOST_CHECK_EQUAL(list[2].getIndex(), 2);
+    BOOST_CHECK_EQUAL(list[1]["a"].getIndex(), 0);
+
+    list.remove(static_cast<size_t>(0));
+    BOOST_CHECK_EQUAL(list[1].getIndex(), 1);
+    BOOST_CHECK_EQUAL(list.add(libconfig::Setting::TypeGroup).getIndex(), 2);
+    BOOST_CHECK_EQUAL(cfg.getIndex(), -1);
+
+    libconfig::Config copy(cfg);
+    BOOST_CHECK_EQUAL(copy["list"][2].getIndex(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(append_path)
+{
+    libconfig::Config cfg("nested_config.cfg");
+    BOOST_CHECK_EQUAL(cfg.getPath(), "");
+    BOOST_CHECK_EQUAL(cfg["server.limits.timeout"].getPath(), "server.limits.timeout");
+
+    std::string path("prefix:");
+    path.reserve(64);
+    const char* data = path.data();
+    cfg["server.limits"].appendPath(path);
+    BOOST_CHECK_EQUAL(path, "prefix:server.limits");
+    BOOST_CHECK(path.data() == data);
+}
+
+BOOST_AUTO_TEST_CASE(source_locations)
+{
+    libconfig::Config cfg;
+    cfg.readString("a = 1;\n@include \"nested_config.cfg\"\nb = (\n  1,\n  { c = 2; }\n);\n");
+
+    BOOST_CHECK_EQUAL(cfg["a"].getSourceLine(), 1);
+    BOOST_CHECK_EQUAL(std::string(cfg["a"].getSourceFile()), "");
+    BOOST_CHECK_EQUAL(cfg["b"].getSourceLine(), 3);
+    BOOST_CHECK_EQUAL(cfg["b.[1]"].getSourceLine(), 5);
+    BOOST_CHECK_EQUAL(cfg["b.[1].c"].getSourceLine(), 5);
+
+    const libconfig::Setting& port = cfg["server.port"];
+    std::string file = port.getSourceFile();
+    BOOST_CHECK(file.size() >= 17 && file.substr(file.size() - 17) == "nested_config.cfg");
+    BOOST_CHECK_EQUAL(port.getSourceLine(), 4);
+    BOOST_CHECK_EQUAL(cfg["server.ports"][1].getSourceLine(), 5);
+    BOOST_CHECK_EQUAL(cfg["handlers.[1]"].getSourceLine(), 13);
+
+    libconfig::Config copy(cfg);
+    BOOST_CHECK_EQUAL(std::string(copy["server.port"].getSourceFile()), file);
+    BOOST_CHECK_EQUAL(copy.add("d", libconfig::Setting::TypeInt).getSourceLine(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(lazy_scalars_match_eager_scalars)
+{
+    libconfig::Config eager("nested_config.cfg");
+    libconfig::Config lazy;
+    lazy.setOption(libconfig::Config::OptionLazyScalars, true);
+    lazy.readFile("nested_config.cfg");
+
+    BOOST_CHECK_EQUAL(lazy["server.limits.retries"].getType(), libconfig::Setting::TypeInt64);
+    BOOST_CHECK_EQUAL(lazy["handlers.[2]"][0].getFormat(), libconfig::Setting::FormatHex);
+    libconfig::Config copy(lazy);
+    BOOST_CHECK(copy == eager);
+
+    int port = lazy["server.port"];
+    float timeout = 0;
+    BOOST_CHECK(lazy.lookupValue("server.limits.timeout", timeout));
+    BOOST_CHECK_EQUAL(port, 8080);
+    BOOST_CHECK_CLOSE(timeout, 2.5f, 0.001);
+    BOOST_CHECK(static_cast<bool>(lazy["handlers.[0].enabled"]));
+    BOOST_CHECK(!static_cast<bool>(lazy["handlers.[1].enabled"]));
+
+    lazy["server.port"] = 9090;
+    BOOST_CHECK_EQUAL(static_cast<int>(lazy["server.port"]), 9090);
+
+    std::ostringstream eager_out, lazy_out;
+    eager["server.port"] = 9090;
+    eager_out << eager;
+    lazy_out << lazy;
+    BOOST_CHECK_EQUAL(eager_out.str(), lazy_out.str());
+}
+
+BOOST_AUTO_TEST_CASE(deeply_nested_config)
+{
+    const int depth = 500;
+    std::string text, path;
+    for (int i = 0; i < depth; i++) {
+        text += "g = { v = [1, 2]; ";
+        path += "g.";
+    }
+    text += "l = (3, 4);";
+    for (int i = 0; i < depth; i++) {
+        text += " };";
+    }
+
+    libconfig::Config cfg;
+    cfg.readString(text);
+    const libconfig::Setting& inner = cfg[path + "l"];
+    BOOST_CHECK_EQUAL(inner.getLength(), 2u);
+    BOOST_CHECK_EQUAL(static_cast<int>(inner[1]), 4);
+    BOOST_CHECK_EQUAL(static_cast<int>(cfg[path + "v"][1]), 2);
+    BOOST_CHECK_EQUAL(inner.getParent().getName(), "g");
+    BOOST_CHECK_THROW(cfg.readString("a = 1; b = { c = 2; c = 3; };"),
+                      libconfig::SettingNameException);
+}
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+BOOST_AUTO_TEST_CASE(move_config)
+{
+    libconfig::Config cfg("nested_config.cfg");
+    const libconfig::Setting* port = &cfg["server.port"];
+
+    libconfig::Config moved(std::move(cfg));
+    BOOST_CHECK_EQUAL(&moved["server.port"], port);
+    BOOST_CHECK_EQUAL(&port->getParent().getParent(), &moved.getRoot());
+    BOOST_CHECK_EQUAL(cfg.getLength(), 0u);
+    cfg.readString("a = 1;");
+    BOOST_CHECK_EQUAL(static_cast<int>(cfg["a"]), 1);
+
+    std::vector<libconfig::Config> configs;
+    configs.reserve(2);
+    configs.push_back(std::move(moved));
+    configs.push_back(libconfig::Config("simple_config.cfg"));
+    BOOST_CHECK_EQUAL(&configs[0]["server.port"], port);
+    BOOST_CHECK_EQUAL(static_cast<int>(configs[1]["int"]), 1);
+
+    cfg = std::move(configs[0]);
+    BOOST_CHECK_EQUAL(&cfg["server.port"], port);
+    BOOST_CHECK_EQUAL(cfg["server.limits"].getPath(), "server.limits");
+
+    libconfig::Config copy;
+    copy = cfg;
+    BOOST_CHECK(copy == cfg);
+    BOOST_CHECK(&copy["server.port"] != port);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(copies_share_until_changed)
+{
+    libconfig::Config cfg("nested_config.cfg");
+    std::ostringstream original;
+    original << cfg;
+
+    libconfig::Config snapshot(cfg);
+    libconfig::Config nested(snapshot);
+    cfg["server.limits.retries"] = 5L;
+    cfg["server.ports"][0] = 81;
+    cfg["handlers"].remove(static_cast<size_t>(0));
+    cfg.add("extra", libconfig::Setting::TypeBoolean);
+
+    std::ostringstream copied, copied_twice;
+    copied << snapshot;
+    copied_twice << nested;
+    BOOST_CHECK_EQUAL(copied.str(), original.str());
+    BOOST_CHECK_EQUAL(copied_twice.str(), original.str());
+    BOOST_CHECK_EQUAL(static_cast<long>(cfg["server.limits.retries"]), 5L);
+
+    snapshot["server.port"] = 1;
+    BOOST_CHECK_EQUAL(static_cast<int>(cfg["server.port"]), 8080);
+    BOOST_CHECK_EQUAL(static_cast<int>(nested["server.port"]), 8080);
+    BOOST_CHECK_EQUAL(&snapshot["server.port"].getParent(), &snapshot["server"]);
+
+    libconfig::Config* source = new libconfig::Config("nested_config.cfg");
+    libconfig::Config orphan(*source);
+    source->readString("a = 1;");
+    delete source;
+    std::ostringstream kept;
+    kept << orphan;
+    BOOST_CHECK_EQUAL(kept.str(), original.str());
+}
+
+BOOST_AUTO_TEST_CASE(setting_refs)
+{
+#ifndef BOOST_NO_CXX11_HDR_TYPE_TRAITS
+    BOOST_STATIC_ASSERT(std::is_trivially_copyable<libconfig::SettingRef>::value);
+#endif
+    libconfig::Config cfg("nested_config.cfg");
+    libconfig::SettingRef server = cfg["server"];
+    BOOST_CHECK(server.isValid());
+    BOOST_CHECK(!libconfig::SettingRef().isValid());
+    BOOST_CHECK_EQUAL(static_cast<int>(server["port"]), 8080);
+    BOOST_CHECK_EQUAL(static_cast<std::string>(server["host"]), "localhost");
+    BOOST_CHECK_EQUAL(server["ports"].getLength(), 3u);
+    BOOST_CHECK_EQUAL(server["limits"].getParent().getPath(), "server");
+
+    int sum = 0;
+    libconfig::SettingRef ports = server["ports"];
+    for (libconfig::SettingRef::iterator it = ports.begin(); it != ports.end(); ++it) {
+        sum += static_cast<int>(*it);
+    }
+    BOOST_CHECK_EQUAL(sum, 80 + 443 + 8080);
+
+    std::vector<std::string> names;
+    for (libconfig::SettingRef::iterator it = server.begin(); it != server.end(); ++it) {
+        names.push_back((*it).getName());
+    }
+    BOOST_CHECK_EQUAL(names.size(), 4u);
+    BOOST_CHECK_EQUAL(names[3], "limits");
+
+    libconfig::SettingRef limits = server["limits"];
+    cfg["server.port"] = 81;
+    BOOST_CHECK(limits.isValid());
+    cfg["server"].remove("host");
+    BOOST_CHECK(!limits.isValid());
+    BOOST_CHECK_THROW(limits.getLength(), libconfig::SettingNotFoundException);
+
+    libconfig::SettingRef name = cfg["name"];
+    cfg.readString("name = \"other\";");
+    BOOST_CHECK(!name.isValid());
+    BOOST_CHECK_EQUAL(static_cast<std::string>(libconfig::SettingRef(cfg)["name"]), "other");
+}
+
+#ifdef LIBCONFIGPP_HAS_MEMORY_RESOURCE
+namespace {
+
+class counting_resource : public std::pmr::memory_resource
+{
+public:
+    counting_resource()
+        : allocations(0),
+          outstanding(0)
+    {}
+
+    size_t allocations;
+    size_t outstanding;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment)
+    {
+        allocations++;
+        outstanding += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment)
+    {
+        outstanding -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(settings_from_memory_resource)
+{
+    libconfig::Config expected("nested_config.cfg");
+    counting_resource resource;
+    {
+        libconfig::Config cfg(&resource);
+        BOOST_CHECK_EQUAL(cfg.getMemoryResource(), &resource);
+        cfg.setOption(libconfig::Config::OptionParallelParse, true);
+        cfg.readFile("nested_config.cfg");
+        BOOST_CHECK(cfg == expected);
+        BOOST_CHECK(resource.allocations > 0);
+
+        libconfig::Config copy(cfg);
+        copy["server"].add("extra", libconfig::Setting::TypeInt) = 1;
+        cfg.readFile("nested_config.cfg");
+        BOOST_CHECK(cfg == expected);
+        BOOST_CHECK_EQUAL(static_cast<int>(copy["server.extra"]), 1);
+
+        // the packed elements of an array come from the resource as well
+        std::vector<int> values(1000, 7);
+        size_t before = resource.outstanding;
+        cfg.setArray("server.values", values);
+        BOOST_CHECK(resource.outstanding >= before + values.size() * sizeof(int));
+        cfg["server"].remove("values");
+        BOOST_CHECK(resource.outstanding < before + values.size() * sizeof(int));
+    }
+    BOOST_CHECK_EQUAL(resource.outstanding, 0u);
+
+    std::pmr::monotonic_buffer_resource arena;
+    libconfig::Config cfg(&arena);
+    cfg.readFile("nested_config.cfg");
+    BOOST_CHECK(cfg == expected);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(repeated_reads)
+{
+    const char* text = "s = \"a\" \"b\" \"c\"; t = \"d\";\n"
+                       "n = 0x1F; i = -7; f = 1.5; l = 123456789012L;\n"
+                       "g = { a = [1, 2]; b = (\"x\" \"y\", 3); };";
+    libconfig::Config cfg;
+    for (int i = 0; i < 3; i++) {
+        cfg.setOption(libconfig::Config::OptionLazyParse, i == 1);
+        cfg.readString(text);
+        BOOST_CHECK_EQUAL(static_cast<std::string>(cfg["s"]), "abc");
+        BOOST_CHECK_EQUAL(static_cast<std::string>(cfg["t"]), "d");
+        BOOST_CHECK_EQUAL(static_cast<int>(cfg["n"]), 31);
+        BOOST_CHECK_EQUAL(static_cast<int>(cfg["i"]), -7);
+        BOOST_CHECK_EQUAL(static_cast<float>(cfg["f"]), 1.5f);
+        BOOST_CHECK_EQUAL(static_cast<long>(cfg["l"]), 123456789012L);
+        BOOST_CHECK_EQUAL(static_cast<int>(cfg["g.a"][1]), 2);
+        BOOST_CHECK_EQUAL(static_cast<std::string>(cfg["g.b"][0]), "xy");
+        BOOST_CHECK_EQUAL(cfg["g.b"][1].getSourceLine(), 3);
+    }
+    libconfig::Config expected("nested_config.cfg");
+    cfg.readFile("nested_config.cfg");
+    BOOST_CHECK(cfg == expected);
+}
+
+BOOST_AUTO_TEST_CASE(compact_keeps_paths_and_values)
+{
+    libconfig::Config cfg("nested_config.cfg");
+    libconfig::Config expected("nested_config.cfg");
+    libconfig::Config snapshot(cfg);
+    for (int i = 0; i < 20; i++) {
+        std::ostringstream name;
+        name << "tmp" << i;
+        cfg["server"].add(name.str(), libconfig::Setting::TypeInt) = i;
+    }
+    for (int i = 0; i < 20; i++) {
+        std::ostringstream name;
+        name << "server.tmp" << i;
+        cfg.remove(name.str());
+    }
+    cfg["server.ports"][1] = 444;
+    cfg["server.ports"][1] = 443;
+    cfg["server.ports"][1].setFormat(libconfig::Setting::FormatHex);
+    cfg["server.ports"][1].setFormat(libconfig::Setting::FormatDefault);
+
+    libconfig::SettingRef port = cfg["server.port"];
+    cfg.compact();
+    BOOST_CHECK(!port.isValid());
+    BOOST_CHECK(cfg == expected);
+    BOOST_CHECK(snapshot == expected);
+    BOOST_CHECK_EQUAL(static_cast<int>(cfg["server.port"]), 8080);
+    BOOST_CHECK_EQUAL(cfg["server.limits.retries"].getPath(), "server.limits.retries");
+    BOOST_CHECK_EQUAL(cfg["server.limits"].getIndex(), 3);
+    BOOST_CHECK_EQUAL(cfg["handlers"][2][1].getFormat(), libconfig::Setting::FormatHex);
+    BOOST_CHECK_EQUAL(cfg["handlers"][1]["path"].getParent().getIndex(), 1);
+
+    std::ostringstream printed, printed_expected;
+    printed << cfg;
+    printed_expected << expected;
+    BOOST_CHECK_EQUAL(printed.str(), printed_expected.str());
+
+    cfg["server"].add("extra", libconfig::Setting::TypeBoolean) = true;
+    BOOST_CHECK(!snapshot.exists("server.extra"));
+
+    cfg.setOption(libconfig::Config::OptionLazyParse, true);
+    cfg.readFile("nested_config.cfg");
+    cfg.compact();
+    BOOST_CHECK(cfg == expected);
+}
+
+BOOST_AUTO_TEST_CASE(string_references)
+{
+    libconfig::Config cfg("nested_config.cfg");
+    const libconfig::Setting& host = cfg["server.host"];
+    const std::string& value = host.getString();
+    BOOST_CHECK_EQUAL(value, "localhost");
+    BOOST_CHECK_EQUAL(&host.getString(), &value);
+    BOOST_CHECK_EQUAL(host.c_str(), value.c_str());
+    BOOST_CHECK_THROW(cfg["server.port"].getString(), libconfig::SettingTypeException);
+
+    const char* path = 0;
+    BOOST_CHECK(cfg.lookupValue("handlers.[1].path", path));
+    BOOST_CHECK_EQUAL(std::string(path), "/api");
+    BOOST_CHECK(!cfg.lookupValue("server.port", path));
+
+    libconfig::SettingRef ref = cfg["server"];
+    BOOST_CHECK_EQUAL(ref["host"].c_str(), value.c_str());
+    libconfig::SettingTable table(cfg);
+    BOOST_CHECK_EQUAL(table.getRoot()["server.host"].getString(), "localhost");
+}
+
+BOOST_AUTO_TEST_CASE(build_tree_in_place)
+{
+    libconfig::Config expected;
+    expected.readString("name = \"built\"; enabled = true; port = 8080; big = 123456789012L;"
+                        "ratio = 0.5; ports = [80, 443]; names = [\"a\", \"b\"];"
+                        "items = (1, \"two\", 3.0);");
+
+    libconfig::Config cfg;
+    cfg.reserve(8);
+    cfg.emplace("name", "built");
+    cfg.emplace("enabled", true);
+    BOOST_CHECK_EQUAL(cfg.emplace("port", 8080).getType(), libconfig::Setting::TypeInt);
+    BOOST_CHECK_EQUAL(cfg.emplace("big", 123456789012L).getType(), libconfig::Setting::TypeInt64);
+    cfg.emplace("ratio", 0.5);
+    libconfig::Setting& ports = cfg.add("ports", libconfig::Setting::TypeArray);
+    ports.reserve(2);
+    ports.append(80);
+    ports.append(443);
+    libconfig::Setting& names = cfg.add("names", libconfig::Setting::TypeArray);
+    names.append("a");
+    names.append(std::string("b"));
+    libconfig::Setting& items = cfg.add("items", libconfig::Setting::TypeList);
+    items.reserve(3);
+    items.append(1);
+    items.append("two");
+    items.append(3.0);
+    BOOST_CHECK(cfg == expected);
+
+    BOOST_CHECK_THROW(ports.append("x"), libconfig::SettingTypeException);
+    BOOST_CHECK_THROW(cfg.emplace("port", 1), libconfig::SettingNameException);
+    BOOST_CHECK_EQUAL(static_cast<int>(ports.emplace("", 8443)), 8443);
+    BOOST_CHECK_EQUAL(ports.getLength(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(bulk_array_conversion)
+{
+    libconfig::Config cfg("nested_config.cfg");
+    std::vector<int> ports;
+    cfg.getArray("server.ports", ports);
+    BOOST_CHECK_EQUAL(ports.size(), 3u);
+    BOOST_CHECK_EQUAL(ports[1], 443);
+
+    cfg["server.ports"][2] = 8443;
+    std::vector<double> widened;
+    cfg["server"].getArray("ports", widened);
+    BOOST_CHECK_EQUAL(widened[2], 8443.0);
+    std::vector<std::string> names;
+    BOOST_CHECK_THROW(cfg.getArray("server.ports", names), libconfig::SettingTypeException);
+    BOOST_CHECK_THROW(cfg.getArray("server", ports), libconfig::SettingTypeException);
+
+    std::vector<long> values;
+    for (long i = 0; i < 1000; i++) {
+        values.push_back(i * 3000000000L);
+    }
+    cfg.setArray("server.ports", values);
+    BOOST_CHECK_EQUAL(cfg["server.ports"].getLength(), 1000u);
+    BOOST_CHECK_EQUAL(static_cast<long>(cfg["server.ports"][999]), 999 * 3000000000L);
+    BOOST_CHECK_THROW(cfg.getArray("server.ports", ports), libconfig::SettingTypeException);
+    std::vector<long> back;
+    cfg.getArray("server.ports", back);
+    BOOST_CHECK(back == values);
+
+    const float weights[] = {0.5f, 1.5f};
+    cfg.setArray("server.limits.weights", weights, 2);
+    BOOST_CHECK_EQUAL(cfg["server.limits.weights"].getType(), libconfig::Setting::TypeArray);
+    BOOST_CHECK_EQUAL(static_cast<float>(cfg["server.limits.weights"][1]), 1.5f);
+    BOOST_CHECK_THROW(cfg.setArray("server.port", weights, 2), libconfig::SettingTypeException);
+    size_t handlers = cfg["handlers"].getLength();
+    BOOST_CHECK_THROW(cfg.setArray("handlers.weights", weights, 2), libconfig::SettingTypeException);
+    BOOST_CHECK_EQUAL(cfg["handlers"].getLength(), handlers);
+    BOOST_CHECK_THROW(cfg.setArray("server.ports.weights", weights, 2),
+                      libconfig::SettingTypeException);
+
+    std::vector<bool> flags(3, true);
+    flags[1] = false;
+    cfg.setArray("flags", flags);
+    libconfig::Config expected;
+    expected.readString("flags = [true, false, true];");
+    BOOST_CHECK(cfg["flags"] == expected["flags"]);
+    const char* labels[] = {"a", "b"};
+    cfg.setArray("labels", labels, 2);
+    std::vector<const char*> more(labels, labels + 2);
+    cfg.setArray("more_labels", more);
+    expected.readString("labels = [\"a\", \"b\"]; more_labels = [\"a\", \"b\"];");
+    BOOST_CHECK(cfg["labels"] == expected["labels"]);
+    BOOST_CHECK(cfg["more_labels"] == expected["more_labels"]);
+
+    libconfig::SettingRef ref = cfg;
+    std::vector<bool> read_flags;
+    ref.getArray("flags", read_flags);
+    BOOST_CHECK(read_flags == flags);
+}
+
+#ifdef LIBCONFIGPP_HAS_THREADS
+namespace {
+
+void read_elements(const libconfig::Config* cfg, long* sum)
+{
+    for (int round = 0; round < 100; round++) {
+        const libconfig::Setting& ports = (*cfg)["server.ports"];
+        for (size_t i = 0; i < ports.getLength(); i++) {
+            *sum += static_cast<int>(ports[static_cast<int>(i)]);
+        }
+        *sum += static_cast<int>((*cfg)["handlers"][2][1]);
+    }
+}
+
+void print_snapshot(const libconfig::Config* snapshot, std::string* printed)
+{
+    for (int round = 0; round < 20; round++) {
+        std::ostringstream o;
+        o << *snapshot;
+        *printed = o.str();
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_element_reads)
+{
+    const libconfig::Config cfg("nested_config.cfg");
+    long sums[4] = {0, 0, 0, 0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.push_back(std::thread(read_elements, &cfg, &sums[i]));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    for (int i = 0; i < 4; i++) {
+        BOOST_CHECK_EQUAL(sums[i], 100 * (80 + 443 + 8080 + 0x20));
+    }
+}
+#endif
+
+#ifdef LIBCONFIGPP_HAS_THREADS
+BOOST_AUTO_TEST_CASE(concurrent_snapshot_reads)
+{
+    libconfig::Config cfg("nested_config.cfg");
+    std::ostringstream original;
+    original << cfg;
+
+    libconfig::Config first(cfg), second(cfg);
+    std::string printed[2];
+    std::thread a(print_snapshot, &first, &printed[0]);
+    std::thread b(print_snapshot, &second, &printed[1]);
+    for (int i = 0; i < 20; i++) {
+        cfg["server.port"] = i;
+        cfg["server.ports"][0] = i;
+    }
+    a.join();
+    b.join();
+    BOOST_CHECK_EQUAL(printed[0], original.str());
+    BOOST_CHECK_EQUAL(printed[1], original.str());
+}
+#endif
+
+namespace {
+
+struct comma_numpunct : std::numpunct<char>
+{
+    char do_decimal_point() const { return ','; }
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(floats_ignore_locale)
+{
+    std::locale previous = std::locale::global(std::locale(std::locale::classic(),
+                                                           new comma_numpunct));
+    const char* names[] = {"de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", "C"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (std::setlocale(LC_NUMERIC, names[i])) {
+            break;
+        }
+    }
+    libconfig::Config cfg;
+    for (int i = 0; i < 2; i++) {
+        cfg.setOption(libconfig::Config::OptionLazyParse, i == 1);
+        cfg.readString("f = 1.5; e = +2.5e1; w = 0x10; n = -7;");
+        BOOST_CHECK_EQUAL(static_cast<float>(cfg["f"]), 1.5f);
+        BOOST_CHECK_EQUAL(static_cast<float>(cfg["e"]), 25.0f);
+        BOOST_CHECK_EQUAL(static_cast<int>(cfg["w"]), 16);
+        BOOST_CHECK_EQUAL(static_cast<int>(cfg["n"]), -7);
+    }
+    std::setlocale(LC_NUMERIC, "C");
+    std::locale::global(previous);
+}
+
+BOOST_AUTO_TEST_CASE(large_list_remove_and_copy)
+{
+    // lists have no names to index, so this stays linear in the length
+    libconfig::Config cfg;
+    libconfig::Setting& list = cfg.add("list", libconfig::Setting::TypeList);
+    for (int i = 0; i < 50000; i++) {
+        list.add(libconfig::Setting::TypeInt) = i;
+    }
+    list.remove(static_cast<size_t>(5));
+    BOOST_CHECK_EQUAL(list.getLength(), 49999u);
+    BOOST_CHECK_EQUAL(static_cast<int>(list[5]), 6);
+    BOOST_CHECK_EQUAL(list[49998].getIndex(), 49998);
+
+    libconfig::Config copy(cfg);
+    const libconfig::Setting& copied = copy["list"];
+    BOOST_CHECK_EQUAL(copied.getLength(), 49999u);
+    BOOST_CHECK_EQUAL(static_cast<int>(copied[4]), 4);
+    BOOST_CHECK_EQUAL(static_cast<int>(copied[49998]), 49999);
+    copy.compact();
+    BOOST_CHECK_EQUAL(static_cast<int>(copy["list"][5]), 6);
+}
+
+#ifdef LIBCONFIGPP_HAS_THREADS
+namespace {
+
+std::string lazy_groups_text()
+{
+    std::ostringstream text;
+    for (int g = 0; g < 8; g++) {
+        text << "g" << g << " = { items = (";
+        for (int i = 0; i < 100; i++) {
+            text << (i ? ", " : "") << "{ v = " << i << "; a = [1, 2, 3]; }";
+        }
+        text << "); };\n";
+    }
+    return text.str();
+}
+
+void sum_lazy_groups(const libconfig::Config* cfg, long* sum)
+{
+    for (int g = 0; g < 8; g++) {
+        std::ostringstream path;
+        path << "g" << g << ".items";
+        const libconfig::Setting& items = (*cfg)[path.str()];
+        for (int i = 0; i < static_cast<int>(items.getLength()); i++) {
+            *sum += static_cast<int>(items[i]["v"]) + static_cast<int>(items[i]["a"][2]);
+        }
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_lazy_reads)
+{
+    libconfig::Config eager;
+    eager.readString(lazy_groups_text());
+
+    libconfig::Config cfg;
+    cfg.setOption(libconfig::Config::OptionLazyParse, true);
+    cfg.readString(lazy_groups_text());
+    libconfig::Config copy(cfg);
+    long sums[4] = {0, 0, 0, 0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.push_back(std::thread(sum_lazy_groups, &cfg, &sums[i]));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    for (int i = 0; i < 4; i++) {
+        BOOST_CHECK_EQUAL(sums[i], 8 * (99 * 100 / 2 + 300));
+    }
+    BOOST_CHECK(cfg == eager);
+    BOOST_CHECK(copy == eager);
+}
+#endif
+
+#ifdef LIBCONFIGPP_HAS_THREADS
+BOOST_AUTO_TEST_CASE(concurrent_lazy_scalar_reads)
+{
+    libconfig::Config eager;
+    eager.readString(lazy_groups_text());
+
+    libconfig::Config cfg;
+    cfg.setOption(libconfig::Config::OptionLazyScalars, true);
+    cfg.readString(lazy_groups_text());
+    libconfig::Config copy(cfg);
+    long sums[4] = {0, 0, 0, 0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.push_back(std::thread(sum_lazy_groups, i % 2 ? &cfg : &copy, &sums[i]));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    for (int i = 0; i < 4; i++) {
+        BOOST_CHECK_EQUAL(sums[i], 8 * (99 * 100 / 2 + 300));
+    }
+    BOOST_CHECK(cfg == eager);
+    BOOST_CHECK(copy == eager);
+}
+#endif
+
+#ifdef LIBCONFIGPP_HAS_THREADS
+namespace {
+
+void find_interned_names(const libconfig::AtomTable* atoms, int* found)
+{
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 2000; i++) {
+            std::ostringstream name;
+            name << "name" << i;
+            libconfig::AtomTable::atom_type atom = atoms->find(name.str());
+            if (atom != libconfig::AtomTable::npos && atoms->name(atom) == name.str()) {
+                (*found)++;
+            }
+        }
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_name_lookups)
+{
+    libconfig::AtomTable atoms;
+    atoms.intern("name0");
+    int found[4] = {0, 0, 0, 0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.push_back(std::thread(find_interned_names, &atoms, &found[i]));
+    }
+    for (int i = 1; i < 2000; i++) {
+        std::ostringstream name;
+        name << "name" << i;
+        atoms.intern(name.str());
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    for (int i = 0; i < 4; i++) {
+        BOOST_CHECK(found[i] >= 20);
+    }
+    BOOST_CHECK_EQUAL(atoms.find("name1999"), 2000u);
+}
+#endif